@@ -47,6 +47,17 @@ using namespace WinErrHandlers;
 #include "fsutil.h"
 #include "ntfsutil.h"
 #include "dosslowfind.h"
+#include "volumereader.h"
+#include "partitiontable.h"
+#include "containerreader.h"
+#include "sequentialreader.h"
+#include "localefmt.h"
+
+#include <vector>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
  
 #define _VERSION "v3.02"
@@ -72,21 +83,43 @@ char sUsage[] =
     " Filter:\n"
     "   -d <count>                        ; Filter by data stream count  \n"
     "   -f <fileFilter>                   ; Filter by filename, use * or ? patterns \n"
+    "   -F <count>                        ; Filter by fragment count \n"
     "   -s <size>                         ; Filter by file size  \n"
     "   -t <relativeModifyDate>           ; Filter by time modified, value is relative days \n"
     "   -z                                ; Force slow style directory search \n"
     "   -v                                ; Verbose (used with -Q ) \n"
     "\n"
+    " Source:\n"
+    "   -i <imageFile>                    ; Scan raw NTFS volume image (ex: dd image) instead of drive \n"
+    "                                     ; Whole disk image (MBR or GPT), scan each NTFS partition as P<n>: \n"
+    "                                     ; Also .vhd, .vhdx (fixed or dynamic) and split raw .001, .002 ... \n"
+    "\n"
+    " Performance:\n"
+    "   -j <threads>                      ; MFT parse threads, overlap with reading, 0=read then parse \n"
+    "   -P                                ; Show MFT load timing on stderr \n"
+    "   -M <megabytes>                    ; Limit memory, stream MFT rather than loading all of it \n"
+    "   -r <kilobytes>                    ; Largest MFT read, nearby fragments are merged, default 4096 \n"
+    "   -O <depth>                        ; Volume reads in flight (queue depth), default 4 \n"
+    "   -b                                ; Benchmark volume reads at queue depth 1, 4, 16 and 64 \n"
+    "   -U                                ; Unbuffered (direct) reads, do not fill the system file cache \n"
+    "   -q                                ; Sequential image scan, read front to back once, no seeks (use -i - for stdin) \n"
+    "   -C <directory>                    ; Keep file catalog snapshot per volume in directory, reused until it is \n"
+    "                                       older than -E, files changed since are not seen, use -R \n"
+    "   -E <seconds>                      ; Snapshot max age (use with -C), default 300 \n"
+    "   -R                                ; Rebuild snapshot (use with -C) \n"
+    "   -p <volumes>                      ; Volumes (or images) scanned at once, default 4, output kept in order \n"
+    "\n"
     " Report:\n"
     "   -A[=s|h|r|d|f|c]                  ; Include attributes, filter on attributes \n"
     "        s=system, h=hidden, r=readonly, d=directory, f=file, c=compressed\n"
     "   -D                                ; Include directory \n"
+    "   -G <count>                        ; Only <count> most fragmented files, include fragments, sparse runs, largest gap \n"
     "   -I                                ; Include mft index \n"
     "   -S                                ; Include size \n"
     "   -T                                ; Include time \n"
     "   -V                                ; Include VCN array \n"
     "   -X                                ; Only deleted entries \n"
-    "   -#                                ; Include stream and name counts \n"
+    "   -#                                ; Include stream, name and hard link counts \n"
     "\n"
     " Query Drive status only, no file search\n"
     "   -Q                                ; Query / Display MFT information only (see -v) \n"
@@ -107,12 +140,23 @@ char sUsage[] =
     "    -s -1000 d: e:              ; File size less than 1000 bytes on d and e drive \n"
     "    -f F* c: d:                 ; Limit scan to files starting with F on either C or D \n"
     "    -d 1 d:                     ; Files with more than 1 data stream on d: drive \n"
+    "    -F 100 d:                   ; Files in more than 100 fragments on d: drive \n"
+    "    -G 20 c:                    ; 20 most fragmented files on c: drive \n"
     "\n"
     "    -X -f * c:                  ; All deleted entries on c: drive \n"
     "    -X -T -S -f *cache  c:      ; Delete files ending in cache, show modify time and size \n"
     "    -X  -f *cache -t -1 c:      ; Deleted files modifies less than 1 day ago \n"
     "\n"
     "    -Q c:                       ; Display special NTFS files\n"
+    "    -i d:\\images\\vol.dd -f *.log ; Files ending in .log in volume image file \n"
+    "    -i d:\\vm\\disk.vhdx -f *.sys ; Files ending in .sys in each NTFS partition of virtual disk \n"
+    "    -q -f *.log -i - < vol.dd   ; Scan volume image streamed on stdin \n"
+    "    -P -j 0 -f *.log -i vol.dd  ; Benchmark serial MFT load, compare with -j 4 \n"
+    "    -M 64 -f *.log c:           ; Files ending in .log, stream MFT using about 64MB \n"
+    "    -b -r 64 c:                 ; Read throughput of c: using 64KB requests \n"
+    "    -C d:\\cache -f *.log c:     ; Files ending in .log, reuse file catalog snapshot in d:\\cache \n"
+    "    -p 8 -f *.log c: d: e: f:   ; Scan four volumes at once, output grouped by volume \n"
+    "    c:\\foo\\*.txt c:\\bar\\*.log ; Both patterns from one load of c: MFT, output grouped by pattern \n"
     "\n"
     "    -z c:\\windows\\system32\\*.dll   ; Force slow directory search. \n"
     "\n";
@@ -204,39 +248,374 @@ int NTFSfastFind(
 
     if (error != 0)
     {
-        std::wcerr << "Error " << ErrorMsg(error).c_str() << std::endl;
+        std::wcerr << "Error " << reportCfg.volume << " " << ErrorMsg(error).c_str() << std::endl;
     }
     return error;
 }
 
-static AnyFilter* pAnyNamefilters;
+// ------------------------------------------------------------------------------------------------
+// Scan NTFS volume image file, ex: raw dd image of a partition, or one partition
+// of a whole disk image (see PartitionTable). Image may be a VHD, VHDX or split
+// raw image (see OpenImageReader).
+int NTFSfastFindImage(
+    const wchar_t* imagePath, 
+    const PartitionTable::DiskPartition* pPartition,    // NULL if image is a volume.
+    NtfsUtil::ReportCfg& reportCfg, 
+    std::wostream& wout,
+    StreamFilter* pStreamFilter)
+{
+    SharePtr<VolumeReader> reader;
+    DWORD error;
+    if (reportCfg.sequential)
+    {
+        SequentialReader* pStream = new SequentialReader();
+        reader = pStream;
+        error = pStream->Open(imagePath);
+    }
+    else
+    {
+        error = OpenImageReader(imagePath, reportCfg.directIO, reader);
+    }
+    if (error != ERROR_SUCCESS)
+    {
+        std::wcerr << "Error opening image " << imagePath << " " << ErrorMsg(error).c_str() << std::endl;
+        return error;
+    }
+
+    DiskInfo diskInfo;
+    ZeroMemory(&diskInfo, sizeof(diskInfo));
+    if (pPartition != NULL)
+    {
+        // Volume offsets are relative to the partition, NtfsUtil start sector stays 0.
+        reader = new RangeReader(reader, pPartition->offset, pPartition->length);
+        diskInfo = pPartition->diskInfo;
+    }
+    else
+    {
+        reportCfg.volume = L"";
+    }
+
+    NtfsUtil ntfsUtil;
+    ntfsUtil.SetReader(reader);
+
+    if (reportCfg.queryInfo)
+        error = ntfsUtil.QueryMFT(imagePath, imagePath, diskInfo, reportCfg, wout, pStreamFilter);
+    else
+        error = ntfsUtil.ScanFiles(imagePath, imagePath, diskInfo, reportCfg, wout, pStreamFilter, -1);
+
+    if (error != 0)
+    {
+        std::wcerr << "Error " << imagePath << " " << reportCfg.volume << " " << ErrorMsg(error).c_str() << std::endl;
+    }
+    return error;
+}
 
 // ------------------------------------------------------------------------------------------------
-void AddFileFilter(const wchar_t* argv, NtfsUtil::ReportCfg& reportCfg, bool matchOn)
+// Output of a scan job, held until all earlier jobs are done (see Release), then written
+// straight to std::wcout. Only the job at the head of the line holds no output.
+class JobOutBuf : public std::wstreambuf
 {
-    if (pAnyNamefilters == NULL) {
-        pAnyNamefilters = new AnyFilter();
-        reportCfg.readFilter->List().push_back(pAnyNamefilters);
+public:
+    JobOutBuf() : 
+        m_direct(false)
+    { setp(m_buf, m_buf + ARRAYSIZE(m_buf)); }
+
+    // Write held output, later output goes straight to std::wcout.
+    void Release()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::wcout.write(m_held.data(), m_held.size());
+        std::wcout.flush();
+        std::wstring().swap(m_held);
+        m_direct = true;
+    }
+
+protected:
+    virtual int_type overflow(int_type ch)
+    {
+        Drain(false);
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    virtual int sync()
+    {
+        Drain(true);
+        return 0;
     }
 
+private:
+    // Move put area to std::wcout or to held output.
+    void Drain(bool flush)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_direct)
+        {
+            std::wcout.write(pbase(), pptr() - pbase());
+            if (flush)
+                std::wcout.flush();
+        }
+        else
+        {
+            m_held.append(pbase(), pptr());
+        }
+        setp(m_buf, m_buf + ARRAYSIZE(m_buf));
+    }
+
+    wchar_t         m_buf[1024];    // Put area, only used by job thread.
+    std::mutex      m_mutex;        // Guards m_held and m_direct.
+    std::wstring    m_held;
+    bool            m_direct;
+};
+
+// ------------------------------------------------------------------------------------------------
+// One volume or image file, scanned by ScanJobs with its own NtfsUtil.
+struct ScanJob
+{
+    ScanJob(const wchar_t* _path, bool _isImage, const NtfsUtil::ReportCfg& _reportCfg) :
+        path(_path), isImage(_isImage), hasPartition(false), reportCfg(_reportCfg), 
+        wout(&outBuf), error(0), done(false)
+    { }
+
+    // One NTFS partition of whole disk image, paths are reported as P<number>:\dir\file
+    void SetPartition(const PartitionTable::DiskPartition& _partition)
+    {
+        hasPartition = true;
+        partition = _partition;
+        _snwprintf_s(volume, ARRAYSIZE(volume), L"P%u:", partition.number);
+        reportCfg.volume = volume;
+    }
+
+    const wchar_t*      path;
+    bool                isImage;
+    bool                hasPartition;
+    PartitionTable::DiskPartition partition;
+    wchar_t             volume[16];
+    NtfsUtil::ReportCfg reportCfg;
+    JobOutBuf           outBuf;
+    std::wostream       wout;       // Output held until earlier jobs are reported.
+    int                 error;
+    bool                done;
+};
+typedef std::vector<SharePtr<ScanJob>> ScanJobList;
+
+// ------------------------------------------------------------------------------------------------
+static int RunScanJob(ScanJob& job, std::wostream& wout, StreamFilter* pStreamFilter)
+{
+    if (job.isImage)
+        return NTFSfastFindImage(job.path, job.hasPartition ? &job.partition : NULL, job.reportCfg, wout, pStreamFilter);
+    return NTFSfastFind(job.path, job.reportCfg, wout, pStreamFilter);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Scan up to maxParallel volumes at once, volumes are usually on different devices so 
+// their reads do not compete. Output is written in job order, the oldest running job 
+// writes straight to std::wcout, later jobs hold theirs until all earlier jobs finish.
+// Return errors or'ed together.
+static int ScanJobs(ScanJobList& jobs, unsigned maxParallel, StreamFilter* pStreamFilter)
+{
+    int error = 0;
+    for (unsigned jobIdx = 0; jobIdx != jobs.size(); jobIdx++)
+    {
+        if (!jobs[jobIdx]->reportCfg.readFilter->IsThreadSafe())
+            maxParallel = 1;    // Filter state is shared by all jobs.
+    }
+
+    if (maxParallel <= 1 || jobs.size() <= 1)
+    {
+        for (unsigned jobIdx = 0; jobIdx != jobs.size(); jobIdx++)
+            error |= RunScanJob(*jobs[jobIdx], std::wcout, pStreamFilter);
+        return error;
+    }
+
+    LocaleFmt::GetNumberFormat();   // Lazy init, do it before threads share it.
+
+    std::mutex jobMutex;
+    std::condition_variable jobDone;
+    size_t nextJob = 0;
+
+    std::vector<std::thread> threads;
+    for (unsigned threadIdx = 0; threadIdx < min(maxParallel, (unsigned)jobs.size()); threadIdx++)
+    {
+        threads.push_back(std::thread([&]()
+        {
+            for (;;)
+            {
+                ScanJob* pJob;
+                {
+                    std::lock_guard<std::mutex> lock(jobMutex);
+                    if (nextJob == jobs.size())
+                        return;
+                    pJob = jobs[nextJob++];
+                }
+
+                int jobError = RunScanJob(*pJob, pJob->wout, pStreamFilter);
+                pJob->wout.flush();
+
+                std::lock_guard<std::mutex> lock(jobMutex);
+                pJob->error = jobError;
+                pJob->done = true;
+                jobDone.notify_all();
+            }
+        }));
+    }
+
+    for (unsigned jobIdx = 0; jobIdx != jobs.size(); jobIdx++)
+    {
+        ScanJob& job = *jobs[jobIdx];
+        job.outBuf.Release();
+
+        std::unique_lock<std::mutex> lock(jobMutex);
+        jobDone.wait(lock, [&job]() { return job.done; });
+        error |= job.error;
+    }
+
+    for (unsigned threadIdx = 0; threadIdx != threads.size(); threadIdx++)
+        threads[threadIdx].join();
+
+    for (unsigned jobIdx = 0; jobIdx != jobs.size(); jobIdx++)
+    {
+        if (jobs[jobIdx]->error != 0)
+            std::wcerr << "Failed " << jobs[jobIdx]->path << " error " << jobs[jobIdx]->error << std::endl;
+    }
+    return error;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Add scan job for image, or one job per NTFS partition if it is a whole disk image.
+// Return 0 on success, else error if disk has no NTFS partition.
+static int AddImageJobs(const wchar_t* imagePath, const NtfsUtil::ReportCfg& reportCfg, ScanJobList& jobs)
+{
+    SharePtr<VolumeReader> imageReader;
+    PartitionTable::PartitionList partitions;
+    if (wcscmp(imagePath, L"-") == 0
+        || OpenImageReader(imagePath, false, imageReader) != ERROR_SUCCESS 
+        || PartitionTable::IsNtfsVolume(*imageReader)
+        || PartitionTable::Read(*imageReader, partitions) != ERROR_SUCCESS)
+    {
+        // Stdin (read once), volume image, or not a disk, scan reports the error.
+        jobs.push_back(new ScanJob(imagePath, true, reportCfg));
+        return ERROR_SUCCESS;
+    }
+
+    unsigned ntfsCnt = 0;
+    for (unsigned partIdx = 0; partIdx < partitions.size(); partIdx++)
+    {
+        if (!partitions[partIdx].isNtfs)
+            continue;
+        ScanJob* pJob = new ScanJob(imagePath, true, reportCfg);
+        pJob->SetPartition(partitions[partIdx]);
+        jobs.push_back(pJob);
+        ntfsCnt++;
+    }
+
+    if (ntfsCnt == 0)
+    {
+        std::wcerr << "Error " << imagePath << " has " << partitions.size() << " partitions, none are NTFS" << std::endl;
+        return ERROR_NOT_FOUND;
+    }
+    return ERROR_SUCCESS;
+}
+
+static AnyFilter* pAnyNamefilters;
+
+// ------------------------------------------------------------------------------------------------
+// Add name part of file pattern to nameFilter, directory part to dirFilter.
+// Return true if pattern has a directory part.
+static bool SplitFilePattern(const wchar_t* argv, wchar_t slash, bool matchOn, FsFilter& nameFilter, FsFilter& dirFilter)
+{
     // Determine if pattern is just name or directory and name. 
     //   directory and name = any slash, ex   dir1\file1.ext1
     //   name only          = no slash
-    const wchar_t* pName = wcsrchr(argv, reportCfg.slash);
+    const wchar_t* pName = wcsrchr(argv, slash);
     if (pName == NULL)
     {
         // name only
-        pAnyNamefilters->List().push_back(new MatchName(argv, IsNameIcase, matchOn));
+        nameFilter.List().push_back(new MatchName(argv, IsNameIcase, matchOn));
+        return false;
     }
-    else
-    {
-        // directory and name
-        if (pName[1] != '\0' && pName[1] != '*')
-            pAnyNamefilters->List().push_back(new MatchName(pName + 1, IsNameIcase, matchOn));
-        std::wstring dirPat(argv, size_t(pName - argv));
-        reportCfg.postFilter->List().push_back(new MatchDirectory(dirPat.c_str(), matchOn));
+
+    // directory and name
+    if (pName[1] != '\0' && pName[1] != '*')
+        nameFilter.List().push_back(new MatchName(pName + 1, IsNameIcase, matchOn));
+    std::wstring dirPat(argv, size_t(pName - argv));
+    dirFilter.List().push_back(new MatchDirectory(dirPat.c_str(), matchOn));
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+void AddFileFilter(const wchar_t* argv, NtfsUtil::ReportCfg& reportCfg, bool matchOn)
+{
+    if (pAnyNamefilters == NULL) {
+        pAnyNamefilters = new AnyFilter();
+        reportCfg.readFilter->List().push_back(pAnyNamefilters);
+    }
+
+    if (SplitFilePattern(argv, reportCfg.slash, matchOn, *pAnyNamefilters, *reportCfg.postFilter))
         reportCfg.directoryFilter = true;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Return true if both arguments start with the same drive letter, ex: c:\foo and C:\bar
+static bool IsSameVolume(const wchar_t* arg1, const wchar_t* arg2)
+{
+    return arg1[0] != '\0' && arg1[1] == ':' && arg2[0] != '\0' && arg2[1] == ':'
+        && towupper(arg1[0]) == towupper(arg2[0]);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Scan several arguments of one volume with a single MFT load, see ReportCfg::targets.
+// Each target gets new name and directory filters, the option filters are copied in so 
+// they keep applying. The shared filter objects are not modified.
+static ScanJob* MakeTargetJob(const std::vector<const wchar_t*>& args, const NtfsUtil::ReportCfg& baseCfg)
+{
+    FsFilter::MatchList baseNames;
+    if (pAnyNamefilters != NULL)
+        baseNames = pAnyNamefilters->List();
+
+    ScanJob* pJob = new ScanJob(args[0], false, baseCfg);
+    NtfsUtil::ReportCfg& reportCfg = pJob->reportCfg;
+
+    AnyFilter* pAllNames = new AnyFilter(baseNames);
+    SharePtr<Match> allNames(pAllNames);
+    bool anyName = false;       // A target accepts all names.
+
+    for (unsigned argIdx = 0; argIdx < args.size(); argIdx++)
+    {
+        const wchar_t* arg = args[argIdx];
+        NtfsUtil::ReportCfg::Target target;
+        target.label = arg;
+        AnyFilter* pNames = new AnyFilter(baseNames);
+        target.nameFilter = pNames;
+        target.dirFilter = new AnyFilter(baseCfg.postFilter->List());
+        if (wcslen(arg) > 3 && arg[1] == ':')
+            SplitFilePattern(arg + (arg[2] == '\\' ? 3 : 2), reportCfg.slash, true, *target.nameFilter, *target.dirFilter);
+
+        anyName |= !pNames->IsValid();
+        pAllNames->List().insert(pAllNames->List().end(), pNames->List().begin() + baseNames.size(), pNames->List().end());
+        reportCfg.targets.push_back(target);
     }
+
+    // Read filter passes files of any target, other option filters still apply to all.
+    AndFilter* pReadFilter = new AndFilter();
+    const FsFilter::MatchList& readList = baseCfg.readFilter->List();
+    for (unsigned matchIdx = 0; matchIdx < readList.size(); matchIdx++)
+    {
+        const Match* pMatch = readList[matchIdx];
+        if (pMatch != pAnyNamefilters)
+            pReadFilter->List().push_back(readList[matchIdx]);
+    }
+    if (!anyName && pAllNames->IsValid())
+        pReadFilter->List().push_back(allNames);
+
+    reportCfg.readFilter = pReadFilter;
+    reportCfg.postFilter = new AnyFilter();
+    reportCfg.directoryFilter = false;
+    return pJob;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -247,6 +626,8 @@ int wmain(int argc, const wchar_t* argv[])
     bool matchOn = true;
     bool doDirIterating = false;
     StreamFilter streamFilter;  // TODO - add members and logic to class
+    std::vector<const wchar_t*> imageFiles;
+    unsigned maxParallel = 4;
 
     if (argc == 1)
     {
@@ -256,7 +637,7 @@ int wmain(int argc, const wchar_t* argv[])
  
     WinErrHandlers::InitUnhandledExceptionFilter();
     
-    GetOpts<wchar_t> getOpts(argc, argv, L"!#A:DIQSTVXvd:f:s:t:z?");
+    GetOpts<wchar_t> getOpts(argc, argv, L"!#A:C:DE:F:G:IM:O:PQRSTUVXbqvd:f:i:j:p:r:s:t:z?");
  
     while (getOpts.GetOpt())
     {
@@ -306,12 +687,60 @@ int wmain(int argc, const wchar_t* argv[])
                 }
             }
             break;
+        case 'C':   // MFT snapshot directory
+            reportCfg.snapshotDir = getOpts.OptArg();
+            break;
         case 'D':   // directory path
             reportCfg.directory = !reportCfg.directory;
             break;
+        case 'E':   // MFT snapshot max age
+            {
+                wchar_t* endPtr;
+                long seconds = wcstol(getOpts.OptArg(), &endPtr, 10);
+                if (endPtr == getOpts.OptArg() || seconds < 0)
+                {
+                    std::wcerr << "Invalid snapshot age argument:" << getOpts.OptArg() << std::endl;
+                    return -1;
+                }
+                reportCfg.snapshotMaxAge = (DWORD)seconds;
+            }
+            break;
+        case 'M':   // memory limit, stream MFT
+            {
+                wchar_t* endPtr;
+                long megabytes = wcstol(getOpts.OptArg(), &endPtr, 10);
+                if (endPtr == getOpts.OptArg() || megabytes <= 0)
+                {
+                    std::wcerr << "Invalid memory limit argument:" << getOpts.OptArg() << std::endl;
+                    return -1;
+                }
+                reportCfg.memoryLimitMB = (DWORD)megabytes;
+            }
+            break;
+
+        case 'O':   // queue depth, volume reads in flight
+            {
+                wchar_t* endPtr;
+                long depth = wcstol(getOpts.OptArg(), &endPtr, 10);
+                if (endPtr == getOpts.OptArg() || depth <= 0 || depth > 256)
+                {
+                    std::wcerr << "Invalid queue depth argument:" << getOpts.OptArg() << std::endl;
+                    return -1;
+                }
+                reportCfg.queueDepth = (unsigned)depth;
+            }
+            break;
+
+        case 'P':   // MFT load performance
+            reportCfg.loadStats = true;
+            break;
+
         case 'I':   // mft index
             reportCfg.mftIndex = !reportCfg.mftIndex;
             break;
+        case 'R':   // rebuild MFT snapshot
+            reportCfg.refreshSnapshot = true;
+            break;
         case 'Q':   // query info
             reportCfg.queryInfo = true;
             reportCfg.attributes = eSystem;
@@ -323,6 +752,9 @@ int wmain(int argc, const wchar_t* argv[])
         case 'T':   // modify time
             reportCfg.modifyTime = !reportCfg.modifyTime;
             break;
+        case 'U':   // unbuffered reads
+            reportCfg.directIO = true;
+            break;
         case 'V':   // show VCN array
             reportCfg.showVcn = true;
             break;
@@ -332,6 +764,12 @@ int wmain(int argc, const wchar_t* argv[])
         case 'v':   // verbose 
             reportCfg.showDetail = true;
             break;
+        case 'b':   // read benchmark
+            reportCfg.benchmark = true;
+            break;
+        case 'q':   // sequential image scan
+            reportCfg.sequential = true;
+            break;
 
         case 'd':   // data stream count
             {
@@ -347,11 +785,83 @@ int wmain(int argc, const wchar_t* argv[])
             matchOn = true;
             break;
 
+        case 'F':   // fragment count
+            {
+                wchar_t* endPtr;
+                long fragCnt = wcstol(getOpts.OptArg(), &endPtr, 10);
+                if (endPtr == getOpts.OptArg())
+                {
+                    std::wcerr << "Invalid Fragment argument:" << getOpts.OptArg() << std::endl;
+                    return -1;
+                }
+                reportCfg.readFilter->List().push_back(new FragCntMatch(labs(fragCnt), fragCnt > 0 ? IsCntGreater : IsCntLess, matchOn));
+                reportCfg.fragInfo = true;
+            }
+            matchOn = true;
+            break;
+
+        case 'G':   // most fragmented files
+            {
+                wchar_t* endPtr;
+                long fileCnt = wcstol(getOpts.OptArg(), &endPtr, 10);
+                if (endPtr == getOpts.OptArg() || fileCnt <= 0)
+                {
+                    std::wcerr << "Invalid most fragmented count:" << getOpts.OptArg() << std::endl;
+                    return -1;
+                }
+                reportCfg.mostFragmented = (DWORD)fileCnt;
+                reportCfg.fragInfo = true;
+            }
+            break;
+
         case 'f':
             AddFileFilter(getOpts.OptArg(), reportCfg, matchOn);
             matchOn = true;
             break;
 
+        case 'i':   // volume image file
+            imageFiles.push_back(getOpts.OptArg());
+            break;
+
+        case 'j':   // MFT parse threads
+            {
+                wchar_t* endPtr;
+                long threads = wcstol(getOpts.OptArg(), &endPtr, 10);
+                if (endPtr == getOpts.OptArg() || threads < 0)
+                {
+                    std::wcerr << "Invalid thread count argument:" << getOpts.OptArg() << std::endl;
+                    return -1;
+                }
+                reportCfg.loadThreads = (unsigned)threads;
+            }
+            break;
+
+        case 'p':   // volumes scanned at once
+            {
+                wchar_t* endPtr;
+                long volumes = wcstol(getOpts.OptArg(), &endPtr, 10);
+                if (endPtr == getOpts.OptArg() || volumes <= 0 || volumes > 64)
+                {
+                    std::wcerr << "Invalid parallel volume argument:" << getOpts.OptArg() << std::endl;
+                    return -1;
+                }
+                maxParallel = (unsigned)volumes;
+            }
+            break;
+
+        case 'r':   // MFT read request size
+            {
+                wchar_t* endPtr;
+                long kilobytes = wcstol(getOpts.OptArg(), &endPtr, 10);
+                if (endPtr == getOpts.OptArg() || kilobytes <= 0 || kilobytes > 1024 * 1024)
+                {
+                    std::wcerr << "Invalid read size argument:" << getOpts.OptArg() << std::endl;
+                    return -1;
+                }
+                reportCfg.readRequestKB = (DWORD)kilobytes;
+            }
+            break;
+
         case 's':   // size
             {
                 wchar_t* endPtr;
@@ -395,16 +905,52 @@ int wmain(int argc, const wchar_t* argv[])
     }
 
     int error = 0;
+    ScanJobList jobs;
+    for (unsigned imageIdx = 0; imageIdx != imageFiles.size(); imageIdx++)
+    {
+        error |= AddImageJobs(imageFiles[imageIdx], reportCfg, jobs);
+    }
+
     if (getOpts.NextIdx() < argc)
     {
+        // Group arguments by volume so each volume's MFT is loaded once.
+        // Query and slow directory search keep one scan per argument.
+        bool groupVolumes = !doDirIterating && !reportCfg.queryInfo;
+        std::vector<std::vector<const wchar_t*>> volumeArgs;
         for (int optIdx = getOpts.NextIdx(); optIdx < argc; optIdx++)
         {
+            unsigned volumeIdx = 0;
+            while (volumeIdx < volumeArgs.size() 
+                && !(groupVolumes && IsSameVolume(volumeArgs[volumeIdx][0], argv[optIdx])
+                    && volumeArgs[volumeIdx].size() < NtfsUtil::ReportCfg::sMaxTargets))
+                volumeIdx++;
+            if (volumeIdx == volumeArgs.size())
+                volumeArgs.push_back(std::vector<const wchar_t*>());
+            volumeArgs[volumeIdx].push_back(argv[optIdx]);
+        }
+
+        for (unsigned volumeIdx = 0; volumeIdx < volumeArgs.size(); volumeIdx++)
+        {
+            if (volumeArgs[volumeIdx].size() > 1)
+            {
+                jobs.push_back(MakeTargetJob(volumeArgs[volumeIdx], reportCfg));
+                continue;
+            }
+
             reportCfg.PushFilter();
             reportCfg.directoryFilter = 
                     !reportCfg.postFilter.IsNull() && reportCfg.postFilter->List().size() != 0;
 
-            const wchar_t* arg = argv[optIdx];
-            if (wcslen(arg) > 3 && arg[1] == ':')
+            const wchar_t* arg = volumeArgs[volumeIdx][0];
+            bool addsFilter = wcslen(arg) > 3 && arg[1] == ':';
+            if (addsFilter || doDirIterating)
+            {
+                // Filter objects are shared by all jobs, finish earlier jobs before they change.
+                error |= ScanJobs(jobs, maxParallel, &streamFilter);
+                jobs.clear();
+            }
+
+            if (addsFilter)
             {
                 if (arg[2] == '\\')
                     AddFileFilter(arg + 3, reportCfg, true);
@@ -415,23 +961,28 @@ int wmain(int argc, const wchar_t* argv[])
             if (doDirIterating)
             {
                 DirSlowFind dirSlowFind(reportCfg, std::wcout);
-                dirSlowFind.ScanFiles(argv[optIdx]);
+                dirSlowFind.ScanFiles(arg);
                 error |= dirSlowFind.m_error;
             }
             else
             {
-                // ToDo - if multi files on same MFT, reuse previous scan !
-                error |= NTFSfastFind(argv[optIdx], reportCfg, std::wcout, &streamFilter);
+                jobs.push_back(new ScanJob(arg, false, reportCfg));
+                if (addsFilter)
+                {
+                    error |= ScanJobs(jobs, maxParallel, &streamFilter);
+                    jobs.clear();
+                }
             }
 
             reportCfg.PopFilter();
         }
     }
-    else
+    else if (imageFiles.empty())
     {
-        error = NTFSfastFind(path, reportCfg, std::wcout, &streamFilter);
+        jobs.push_back(new ScanJob(path, false, reportCfg));
     }
 
+    error |= ScanJobs(jobs, maxParallel, &streamFilter);
 	return error;
 }
 
@@ -0,0 +1,124 @@
+// ------------------------------------------------------------------------------------------------
+// Decode run lists (mapping pairs) of non-resident attributes, measure fragmentation.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "DataRun.h"
+
+#include <string.h>
+
+// Mask of low n bytes, and shift which sign extends a value of n bytes.
+static const ULONGLONG sByteMask[9] = 
+{
+    0, 0xff, 0xffff, 0xffffff, 0xffffffff, 0xffffffffffULL, 0xffffffffffffULL, 0xffffffffffffffULL, 
+    0xffffffffffffffffULL
+};
+static const unsigned sSignShift[9] = { 0, 56, 48, 40, 32, 24, 16, 8, 0 };
+
+// Fast path loads 8 bytes for length and offset, even if they are shorter.
+static const unsigned sMaxLoad = 1 + 8 + 8;
+
+// ------------------------------------------------------------------------------------------------
+DataRunIter::DataRunIter(const NTFS_ATTRIBUTE& ntfsAttr) :
+    m_pRun((const BYTE*)&ntfsAttr + ntfsAttr.Attr.NonResident.wDatarunOffset),
+    m_pNext(NULL),
+    m_pEnd((const BYTE*)&ntfsAttr + ntfsAttr.wFullLength),
+    m_clusters(0),
+    m_lcn(0),
+    m_sparse(false),
+    m_valid(false)
+{
+    Decode();
+}
+
+// ------------------------------------------------------------------------------------------------
+void DataRunIter::Decode()
+{
+    m_valid = false;
+    if (m_pRun >= m_pEnd)
+        return;
+
+    unsigned lenSize = m_pRun[0] & 0x0f;
+    unsigned offSize = m_pRun[0] >> 4;
+    const BYTE* pValue = m_pRun + 1;
+    if (lenSize == 0 || lenSize > 8 || offSize > 8 || lenSize + offSize > (size_t)(m_pEnd - pValue))
+        return;     // End marker (0) or bad run.
+
+    ULONGLONG len = 0;
+    ULONGLONG off = 0;
+    if ((size_t)(m_pEnd - m_pRun) >= sMaxLoad)
+    {
+        memcpy(&len, pValue, sizeof(len));
+        memcpy(&off, pValue + lenSize, sizeof(off));
+    }
+    else
+    {
+        // Near end of attribute, copy only the bytes of the run.
+        memcpy(&len, pValue, lenSize);
+        memcpy(&off, pValue + lenSize, offSize);
+    }
+
+    unsigned shift = sSignShift[offSize];
+    m_clusters = (LONGLONG)(len & sByteMask[lenSize]);
+    m_lcn     += (LONGLONG)((off & sByteMask[offSize]) << shift) >> shift;
+    m_sparse   = (offSize == 0);
+    m_pNext    = pValue + lenSize + offSize;
+    m_valid    = true;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool DataRun::Decode(const NTFS_ATTRIBUTE& ntfsAttr, DWORD bytesPerCluster, RunList* pRuns, FragInfo* pFrag)
+{
+    FragInfo frag;
+    LONGLONG nextLcn = -1;      // Cluster after previous allocated run.
+
+    DataRunIter runIter(ntfsAttr);
+    for (; runIter.IsValid(); runIter.Next())
+    {
+        if (pRuns != NULL)
+            pRuns->push_back(std::pair<LONGLONG,LONGLONG>(runIter.Lcn(), runIter.Clusters() * bytesPerCluster));
+
+        if (runIter.IsSparse())
+        {
+            frag.sparseRuns++;
+            continue;
+        }
+        if (runIter.Lcn() != nextLcn)
+        {
+            frag.fragments++;
+            if (nextLcn >= 0)
+                frag.largestGap = max(frag.largestGap, 
+                    runIter.Lcn() > nextLcn ? runIter.Lcn() - nextLcn : nextLcn - runIter.Lcn());
+        }
+        nextLcn = runIter.Lcn() + runIter.Clusters();
+    }
+
+    if (pFrag != NULL)
+        pFrag->Add(frag);
+    return runIter.AtEnd();
+}
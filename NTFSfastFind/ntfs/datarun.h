@@ -0,0 +1,123 @@
+// ------------------------------------------------------------------------------------------------
+// Decode run lists (mapping pairs) of non-resident attributes, measure fragmentation.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+#include "NtfsTypes.h"
+
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Fragmentation of a file, summed over the run lists of its $DATA attributes.
+struct FragInfo
+{
+    FragInfo() :
+        fragments(0), sparseRuns(0), largestGap(0)
+    { }
+
+    void Add(const FragInfo& other)
+    {
+        fragments  += other.fragments;
+        sparseRuns += other.sparseRuns;
+        largestGap  = max(largestGap, other.largestGap);
+    }
+
+    DWORD       fragments;      // Allocated runs which do not follow the previous allocated run.
+    DWORD       sparseRuns;     // Runs without clusters on disk.
+    LONGLONG    largestGap;     // Largest jump in clusters between allocated runs, either way.
+};
+
+// ------------------------------------------------------------------------------------------------
+// Walk the run list of a non-resident attribute in place.
+//   ( [header] [length] [offset] ) ... repeat until header is zero.
+//   Header low nibble is byte size of length, high nibble byte size of offset.
+//   Offset is signed and relative to LCN of previous run, no offset is a sparse run.
+// Values are read with one 8 byte load and masked using tables, no per byte loops.
+// Walk stops at the end marker or at the first run which is bad or does not fit.
+//
+//  Ex:
+//      for (DataRunIter runIter(ntfsAttr); runIter.IsValid(); runIter.Next())
+//          if (!runIter.IsSparse())
+//              ... runIter.Lcn(), runIter.Clusters()
+
+class DataRunIter
+{
+public:
+    // Attribute must be non-resident and lie in memory for wFullLength bytes.
+    DataRunIter(const NTFS_ATTRIBUTE& ntfsAttr);
+
+    bool IsValid() const
+    { return m_valid; }
+
+    // True if walk stopped at the end marker rather than a bad run.
+    bool AtEnd() const
+    { return m_pRun < m_pEnd && *m_pRun == 0; }
+
+    void Next()
+    {
+        m_pRun = m_pNext;
+        Decode();
+    }
+
+    LONGLONG Clusters() const
+    { return m_clusters; }
+
+    // Cluster on disk, LCN of previous run for sparse runs.
+    LONGLONG Lcn() const
+    { return m_lcn; }
+
+    bool IsSparse() const
+    { return m_sparse; }
+
+private:
+    void Decode();
+
+    const BYTE* m_pRun;
+    const BYTE* m_pNext;
+    const BYTE* m_pEnd;
+    LONGLONG    m_clusters;
+    LONGLONG    m_lcn;
+    bool        m_sparse;
+    bool        m_valid;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Decode whole run list in one pass.
+class DataRun
+{
+public:
+    // List of (disk_LCN, disk_byte_length), same as MFTRecord::FileOnDiskList.
+    typedef std::vector<std::pair<LONGLONG,LONGLONG>> RunList;
+
+    // Append runs to pRuns and add fragmentation to pFrag, either may be NULL.
+    // Return false if run list is bad (does not end with the end marker).
+    static bool Decode(const NTFS_ATTRIBUTE& ntfsAttr, DWORD bytesPerCluster, RunList* pRuns, FragInfo* pFrag);
+};
@@ -0,0 +1,110 @@
+// ------------------------------------------------------------------------------------------------
+// Compact directory table, MFT index to parent and name, used to build directory paths.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "DirTable.h"
+
+const unsigned sMaxDepth = 256;     // Guard against parent loops in damaged MFT.
+
+// ------------------------------------------------------------------------------------------------
+void DirTable::Clear()
+{
+    m_nodes.clear();
+    m_names.clear();
+    m_count = 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+void DirTable::Add(DWORD mftIndex, DWORD parent, const wchar_t* pName, unsigned nameLen)
+{
+    if (Has(mftIndex) || mftIndex >= m_limit)
+        return;
+
+    if (mftIndex >= m_nodes.size())
+    {
+        Node noDir;
+        noDir.parent  = sNoDir;
+        noDir.nameOff = 0;
+        m_nodes.resize(mftIndex + 1, noDir);
+    }
+
+    // $FILE_NAME length is a byte, it fits the length slot.
+    Node& node = m_nodes[mftIndex];
+    node.parent  = parent;
+    node.nameOff = (DWORD)m_names.size();
+    m_names.push_back((wchar_t)min(nameLen, 0xffffu));
+    m_names.insert(m_names.end(), pName, pName + m_names.back());
+    m_count++;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Walk to the root once for the path length, then fill the path from its end.
+bool DirTable::GetPath(DWORD mftIndex, wchar_t slash, std::wstring& path, DWORD& missing) const
+{
+    unsigned depth = 0;
+    size_t pathLen = 0;
+
+    DWORD dirIdx = mftIndex;
+    while (depth < sMaxDepth)
+    {
+        if (!Has(dirIdx))
+        {
+            missing = dirIdx;
+            return false;
+        }
+
+        const Node& node = m_nodes[dirIdx];
+        if (node.parent == dirIdx)
+            break;      // root
+
+        pathLen += 1 + m_names[node.nameOff];
+        depth++;
+        dirIdx = node.parent;
+    }
+
+    path.resize(pathLen);
+    size_t pathOff = pathLen;
+    dirIdx = mftIndex;
+    for (unsigned level = 0; level < depth; level++)
+    {
+        const Node& node = m_nodes[dirIdx];
+        unsigned nameLen = m_names[node.nameOff];
+        pathOff -= nameLen;
+        path.replace(pathOff, nameLen, m_names.data() + node.nameOff + 1, nameLen);
+        path[--pathOff] = slash;
+        dirIdx = node.parent;
+    }
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t DirTable::MemorySize() const
+{
+    return m_nodes.capacity() * sizeof(Node) + m_names.capacity() * sizeof(wchar_t);
+}
@@ -0,0 +1,111 @@
+// ------------------------------------------------------------------------------------------------
+// Compact directory table, MFT index to parent and name, used to build directory paths.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Directory table, holds only parent index and name of each directory so paths can be built
+// without keeping the MFT in memory. Parent tree is a flat array indexed by MFT index, names
+// are in a pool, a path is only built when asked for.
+//
+//  Ex:
+//      dirTable.Add(5, 5, L".", 1);            // root
+//      dirTable.Add(40, 5, L"Users", 5);
+//      dirTable.GetPath(40, '\\', path, missing);    // path = \Users
+
+class DirTable
+{
+public:
+    struct DirEntry
+    {
+        DWORD           mftIndex;
+        DWORD           parent;
+        std::wstring    name;
+    };
+    typedef std::vector<DirEntry> EntryList;
+
+    DirTable() :
+        m_count(0), m_limit(sNoDir)
+    { }
+
+    // Directories are removed, the limit is kept.
+    void Clear();
+
+    // Records in the MFT, indexes at or above are not added. An index sizes the table, 
+    // one read from a damaged record must not allocate it.
+    void SetLimit(DWORD records)
+    { m_limit = records; }
+
+    void Add(DWORD mftIndex, DWORD parent, const wchar_t* pName, unsigned nameLen);
+
+    void Add(const EntryList& entryList)
+    {
+        for (unsigned entryIdx = 0; entryIdx != entryList.size(); entryIdx++)
+        {
+            const DirEntry& entry = entryList[entryIdx];
+            Add(entry.mftIndex, entry.parent, entry.name.c_str(), (unsigned)entry.name.length());
+        }
+    }
+
+    bool Has(DWORD mftIndex) const
+    { return mftIndex < m_nodes.size() && m_nodes[mftIndex].parent != sNoDir; }
+
+    // Build path of directory, ex: \Users\Dennis, root directory is empty.
+    // Path is overwritten in place, reuse it to avoid allocating per call.
+    // Return false and set missing to first ancestor not in table.
+    bool GetPath(DWORD mftIndex, wchar_t slash, std::wstring& path, DWORD& missing) const;
+
+    size_t size() const
+    { return m_count; }
+
+    // Approximate bytes used by table.
+    size_t MemorySize() const;
+
+private:
+    friend class MFTSnapshot;   // Writes and loads nodes and names as they are.
+
+    static const DWORD sNoDir = 0xffffffff;
+
+    struct Node
+    {
+        DWORD   parent;         // sNoDir if record is not in table.
+        DWORD   nameOff;        // Offset in m_names of name length, followed by name.
+    };
+
+    std::vector<Node>       m_nodes;    // Indexed by MFT index.
+    std::vector<wchar_t>    m_names;    // Name pool, names are not terminated.
+    size_t                  m_count;    // Directories in table.
+    DWORD                   m_limit;    // See SetLimit.
+};
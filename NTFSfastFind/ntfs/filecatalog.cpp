@@ -0,0 +1,251 @@
+// ------------------------------------------------------------------------------------------------
+// Columnar catalog of MFT files, one array per field, built while the MFT is loaded.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "FileCatalog.h"
+
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+void FileCatalog::clear()
+{
+    resize(0);
+}
+
+// ------------------------------------------------------------------------------------------------
+void FileCatalog::reserve(size_t rows)
+{
+    m_mftIndex.reserve(rows);
+    m_parentRef.reserve(rows);
+    m_seq.reserve(rows);
+    m_attributes.reserve(rows);
+    m_state.reserve(rows);
+    m_fileSize.reserve(rows);
+    m_diskSize.reserve(rows);
+    m_create.reserve(rows);
+    m_modify.reserve(rows);
+    m_modfil.reserve(rows);
+    m_access.reserve(rows);
+    m_nameCnt.reserve(rows);
+    m_streamCnt.reserve(rows);
+    m_hardLinks.reserve(rows);
+    m_nameOffset.reserve(rows);
+    m_nameLen.reserve(rows);
+    m_nameType.reserve(rows);
+    m_targetMask.reserve(rows);
+    m_frag.reserve(rows);
+}
+
+// ------------------------------------------------------------------------------------------------
+void FileCatalog::resize(size_t rows)
+{
+    m_mftIndex.resize(rows);
+    m_parentRef.resize(rows);
+    m_seq.resize(rows);
+    m_attributes.resize(rows);
+    m_state.resize(rows);
+    m_fileSize.resize(rows);
+    m_diskSize.resize(rows);
+    m_create.resize(rows);
+    m_modify.resize(rows);
+    m_modfil.resize(rows);
+    m_access.resize(rows);
+    m_nameCnt.resize(rows);
+    m_streamCnt.resize(rows);
+    m_hardLinks.resize(rows);
+    m_nameOffset.resize(rows);
+    m_nameLen.resize(rows);
+    m_nameType.resize(rows);
+    m_targetMask.resize(rows);
+    m_frag.resize(rows);
+}
+
+// ------------------------------------------------------------------------------------------------
+void FileCatalog::push_back(const MFTEntry& entry)
+{
+    resize(size() + 1);
+    Set(size() - 1, entry);
+}
+
+// ------------------------------------------------------------------------------------------------
+MFTEntry FileCatalog::Get(size_t row) const
+{
+    MFTEntry entry;
+    entry.mftIndex      = m_mftIndex[row];
+    entry.parentRef     = m_parentRef[row];
+    entry.seq           = m_seq[row];
+    entry.dwAttributes  = m_attributes[row];
+    entry.inUse         = (m_state[row] & sInUse) != 0;
+    entry.sparse        = (m_state[row] & sSparse) != 0;
+    entry.attrList      = (m_state[row] & sAttrList) != 0;
+    entry.hasSize       = (m_state[row] & sHasSize) != 0;
+    entry.fileSize      = m_fileSize[row];
+    entry.diskSize      = m_diskSize[row];
+    entry.n64Create     = m_create[row];
+    entry.n64Modify     = m_modify[row];
+    entry.n64Modfil     = m_modfil[row];
+    entry.n64Access     = m_access[row];
+    entry.nameCnt       = m_nameCnt[row];
+    entry.streamCnt     = m_streamCnt[row];
+    entry.hardLinks     = m_hardLinks[row];
+    entry.nameOffset    = m_nameOffset[row];
+    entry.nameLen       = m_nameLen[row];
+    entry.nameType      = m_nameType[row];
+    entry.targetMask    = m_targetMask[row];
+    entry.frag          = m_frag[row];
+    return entry;
+}
+
+// ------------------------------------------------------------------------------------------------
+void FileCatalog::Set(size_t row, const MFTEntry& entry)
+{
+    m_mftIndex[row]     = entry.mftIndex;
+    m_parentRef[row]    = entry.parentRef;
+    m_seq[row]          = entry.seq;
+    m_attributes[row]   = entry.dwAttributes;
+    m_state[row]        = (entry.inUse ? sInUse : 0) | (entry.sparse ? sSparse : 0) | (entry.attrList ? sAttrList : 0)
+                            | (entry.hasSize ? sHasSize : 0);
+    m_fileSize[row]     = entry.fileSize;
+    m_diskSize[row]     = entry.diskSize;
+    m_create[row]       = entry.n64Create;
+    m_modify[row]       = entry.n64Modify;
+    m_modfil[row]       = entry.n64Modfil;
+    m_access[row]       = entry.n64Access;
+    m_nameCnt[row]      = entry.nameCnt;
+    m_streamCnt[row]    = entry.streamCnt;
+    m_hardLinks[row]    = entry.hardLinks;
+    m_nameOffset[row]   = entry.nameOffset;
+    m_nameLen[row]      = entry.nameLen;
+    m_nameType[row]     = entry.nameType;
+    m_targetMask[row]   = entry.targetMask;
+    m_frag[row]         = entry.frag;
+}
+
+// ------------------------------------------------------------------------------------------------
+template <typename T>
+static void AppendColumn(std::vector<T>& column, const std::vector<T>& other)
+{
+    column.insert(column.end(), other.begin(), other.end());
+}
+
+// ------------------------------------------------------------------------------------------------
+void FileCatalog::Append(const FileCatalog& other, DWORD nameBase)
+{
+    size_t firstNew = size();
+    AppendColumn(m_mftIndex, other.m_mftIndex);
+    AppendColumn(m_parentRef, other.m_parentRef);
+    AppendColumn(m_seq, other.m_seq);
+    AppendColumn(m_attributes, other.m_attributes);
+    AppendColumn(m_state, other.m_state);
+    AppendColumn(m_fileSize, other.m_fileSize);
+    AppendColumn(m_diskSize, other.m_diskSize);
+    AppendColumn(m_create, other.m_create);
+    AppendColumn(m_modify, other.m_modify);
+    AppendColumn(m_modfil, other.m_modfil);
+    AppendColumn(m_access, other.m_access);
+    AppendColumn(m_nameCnt, other.m_nameCnt);
+    AppendColumn(m_streamCnt, other.m_streamCnt);
+    AppendColumn(m_hardLinks, other.m_hardLinks);
+    AppendColumn(m_nameOffset, other.m_nameOffset);
+    AppendColumn(m_nameLen, other.m_nameLen);
+    AppendColumn(m_nameType, other.m_nameType);
+    AppendColumn(m_targetMask, other.m_targetMask);
+    AppendColumn(m_frag, other.m_frag);
+
+    for (size_t row = firstNew; row < m_nameOffset.size(); row++)
+        m_nameOffset[row] += nameBase;
+}
+
+// ------------------------------------------------------------------------------------------------
+void FileCatalog::SelectActive(size_t rowCnt, bool deleted, Rows& rows) const
+{
+    BYTE wantState = deleted ? 0 : sInUse;
+    rows.clear();
+    for (size_t row = 0; row < rowCnt && row < m_state.size(); row++)
+    {
+        if ((m_state[row] & sInUse) == wantState && m_nameLen[row] != 0)
+            rows.push_back((DWORD)row);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Orders rows as NtfsUtil MoreFragmented orders files.
+class MoreFragmentedRow
+{
+public:
+    MoreFragmentedRow(const FileCatalog& catalog, const wchar_t* names) :
+        m_catalog(catalog), m_names(names)
+    { }
+
+    bool operator()(DWORD lhs, DWORD rhs) const
+    {
+        const FragInfo& lhsFrag = m_catalog.m_frag[lhs];
+        const FragInfo& rhsFrag = m_catalog.m_frag[rhs];
+        if (lhsFrag.fragments != rhsFrag.fragments)
+            return lhsFrag.fragments > rhsFrag.fragments;
+        if (lhsFrag.largestGap != rhsFrag.largestGap)
+            return lhsFrag.largestGap > rhsFrag.largestGap;
+
+        const wchar_t* pLhsName = m_names + m_catalog.m_nameOffset[lhs];
+        const wchar_t* pRhsName = m_names + m_catalog.m_nameOffset[rhs];
+        BYTE lhsLen = m_catalog.m_nameLen[lhs];
+        BYTE rhsLen = m_catalog.m_nameLen[rhs];
+        if (lhsLen != rhsLen || !std::equal(pLhsName, pLhsName + lhsLen, pRhsName))
+            return std::lexicographical_compare(pLhsName, pLhsName + lhsLen, pRhsName, pRhsName + rhsLen);
+        return (DWORD)m_catalog.m_parentRef[lhs] < (DWORD)m_catalog.m_parentRef[rhs];
+    }
+
+private:
+    const FileCatalog&  m_catalog;
+    const wchar_t*      m_names;
+};
+
+// ------------------------------------------------------------------------------------------------
+void FileCatalog::SelectMostFragmented(size_t rowCnt, size_t keep, bool deleted, const wchar_t* names, Rows& rows) const
+{
+    // Fragment and state columns are scanned, other fields are only read to break ties.
+    BYTE wantState = deleted ? 0 : sInUse;
+    rows.clear();
+    for (size_t row = 0; row < rowCnt && row < m_frag.size(); row++)
+    {
+        if (m_frag[row].fragments > 1 && (m_state[row] & sInUse) == wantState && m_nameLen[row] != 0)
+            rows.push_back((DWORD)row);
+    }
+
+    MoreFragmentedRow moreFragmented(*this, names);
+    if (rows.size() > keep)
+    {
+        std::partial_sort(rows.begin(), rows.begin() + keep, rows.end(), moreFragmented);
+        rows.resize(keep);
+    }
+    else
+    {
+        std::sort(rows.begin(), rows.end(), moreFragmented);
+    }
+}
@@ -0,0 +1,140 @@
+// ------------------------------------------------------------------------------------------------
+// Columnar catalog of MFT files, one array per field, built while the MFT is loaded.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+#include "DataRun.h"
+
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Fields of a kept MFT record needed to report it, collected while filtering so the record
+// is not parsed a second time, see MFTRecord::FilterRecords. One row of FileCatalog.
+struct MFTEntry
+{
+    LONGLONG    n64Create;
+    LONGLONG    n64Modify;
+    LONGLONG    n64Modfil;
+    LONGLONG    n64Access;
+    LONGLONG    diskSize;
+    LONGLONG    fileSize;
+    LONGLONG    parentRef;      // Seq[2] parent-dir[6] MFT entry
+    ULONGLONG   targetMask;     // Bit per target filter which matched.
+    DWORD       mftIndex;
+    DWORD       dwAttributes;
+    DWORD       nameOffset;     // Name in MFTEntryList::names, not terminated.
+    BYTE        nameLen;
+    BYTE        nameType;       // MFTFileInfoTypes, extensions may hold a preferred name.
+    bool        inUse;
+    bool        sparse;
+    bool        attrList;       // Has $ATTRIBUTE_LIST, filtered once extensions are merged.
+    bool        hasSize;        // Sizes set from first segment of non resident $DATA.
+    WORD        seq;            // MFT_FILE_HEADER::wSequence
+    WORD        nameCnt;
+    WORD        streamCnt;
+    WORD        hardLinks;      // MFT_FILE_HEADER::wHardLinks
+    FragInfo    frag;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Kept MFT files stored a column per field (structure of arrays), names are in a separate
+// UTF-16 pool (MFTEntryList::names). Scans which test one or two fields, such as the in use
+// state or fragment count, walk a few dense arrays rather than every field of every row,
+// and a row costs about 100 bytes against a 1 KB or 4 KB record. Scans keep only the
+// catalog, records are not kept once loaded, see MFTEntryList::FilterRow.
+//
+//  Ex:
+//      FileCatalog::Rows rows;
+//      catalog.SelectActive(catalog.size(), true, rows);     // Deleted files with a name.
+//      MFTEntry entry = catalog.Get(rows[0]);
+
+class FileCatalog
+{
+public:
+    typedef std::vector<DWORD> Rows;    // Row index, ascending unless sorted.
+
+    // State bits.
+    static const BYTE sInUse    = 0x01;
+    static const BYTE sSparse   = 0x02;
+    static const BYTE sAttrList = 0x04;
+    static const BYTE sHasSize  = 0x08;
+
+    size_t size() const
+    { return m_mftIndex.size(); }
+    bool empty() const
+    { return m_mftIndex.empty(); }
+
+    void clear();
+    void reserve(size_t rows);
+    void resize(size_t rows);
+
+    void push_back(const MFTEntry& entry);
+    void pop_back()
+    { resize(size() - 1); }
+    MFTEntry back() const
+    { return Get(size() - 1); }
+
+    // Assemble or store all fields of row.
+    MFTEntry Get(size_t row) const;
+    void Set(size_t row, const MFTEntry& entry);
+
+    // Append rows of other catalog, adding nameBase to their name offsets.
+    void Append(const FileCatalog& other, DWORD nameBase);
+
+    // Set rows of the first rowCnt, ascending, with a name and the in use state wanted.
+    void SelectActive(size_t rowCnt, bool deleted, Rows& rows) const;
+
+    // Set rows of the keep most fragmented files (fragments > 1) of the first rowCnt, with a
+    // name and the in use state wanted. Most fragments first, then largest gap, then name 
+    // (names is the name pool) and parent.
+    void SelectMostFragmented(size_t rowCnt, size_t keep, bool deleted, const wchar_t* names, Rows& rows) const;
+
+    // Columns, one value per row.
+    std::vector<DWORD>      m_mftIndex;
+    std::vector<LONGLONG>   m_parentRef;
+    std::vector<WORD>       m_seq;
+    std::vector<DWORD>      m_attributes;
+    std::vector<BYTE>       m_state;        // sInUse, sSparse, sAttrList, sHasSize
+    std::vector<LONGLONG>   m_fileSize;
+    std::vector<LONGLONG>   m_diskSize;
+    std::vector<LONGLONG>   m_create;
+    std::vector<LONGLONG>   m_modify;
+    std::vector<LONGLONG>   m_modfil;
+    std::vector<LONGLONG>   m_access;
+    std::vector<WORD>       m_nameCnt;
+    std::vector<WORD>       m_streamCnt;
+    std::vector<WORD>       m_hardLinks;
+    std::vector<DWORD>      m_nameOffset;
+    std::vector<BYTE>       m_nameLen;
+    std::vector<BYTE>       m_nameType;
+    std::vector<ULONGLONG>  m_targetMask;
+    std::vector<FragInfo>   m_frag;
+};
@@ -0,0 +1,792 @@
+// ------------------------------------------------------------------------------------------------
+// Pipelined MFT loader, overlap volume reads with MFT record parsing and filtering.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "MFTLoader.h"
+
+#include <assert.h>
+#include <chrono>
+#include <thread>
+
+typedef std::chrono::steady_clock Clock;
+
+// ------------------------------------------------------------------------------------------------
+static double ElapsedMs(const Clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// ------------------------------------------------------------------------------------------------
+MFTLoader::MFTLoader(VolumeReader* pReader, LONGLONG n64StartPos, DWORD dwRecSize, DWORD dwBytesPerCluster) :
+    m_pReader(pReader),
+    m_n64StartPos(n64StartPos),
+    m_dwRecSize(dwRecSize),
+    m_dwBytesPerCluster(dwBytesPerCluster),
+    m_bytesPerSector(RecordFixup::sMinStride),
+    m_pSink(NULL),
+    m_pDirTable(NULL),
+    m_select(RecordClass::sAnyFile),
+    m_pPlan(NULL),
+    m_pFilter(NULL),
+    m_pOutMFT(NULL),
+    m_pOutEntries(NULL),
+    m_pSplitParser(NULL),
+    m_pSplitFixup(NULL),
+    m_splitRecords(0),
+    m_splitKept(0),
+    m_nextCommit(0),
+    m_committing(false),
+    m_readDone(false),
+    m_error(ERROR_SUCCESS)
+{
+    ZeroMemory(m_typeCnt, sizeof(m_typeCnt));
+}
+
+// ------------------------------------------------------------------------------------------------
+// Leave one core for the reader, parsing is cheap so more than a few workers does not help.
+unsigned MFTLoader::DefaultWorkers()
+{
+    unsigned cores = std::thread::hardware_concurrency();
+    return (cores <= 2) ? 1 : min(cores - 1, 4u);
+}
+
+// ------------------------------------------------------------------------------------------------
+int MFTLoader::Load(const MFTRecord::FileOnDiskList& runs, const FsFilter& filter, Buffer& outMFT)
+{
+    return LoadTo(runs, filter, &outMFT, NULL);
+}
+
+// ------------------------------------------------------------------------------------------------
+int MFTLoader::Load(const MFTRecord::FileOnDiskList& runs, const FsFilter& filter, MFTEntryList& outEntries)
+{
+    return LoadTo(runs, filter, NULL, &outEntries);
+}
+
+// ------------------------------------------------------------------------------------------------
+int MFTLoader::LoadTo(const MFTRecord::FileOnDiskList& runs, const FsFilter& filter, Buffer* pOutMFT, 
+    MFTEntryList* pOutEntries)
+{
+    Clock::time_point start = Clock::now();
+
+    m_pFilter = &filter;
+    m_pOutMFT = pOutMFT;
+    m_pOutEntries = pOutEntries;
+    size_t entryBegin = (pOutEntries != NULL) ? pOutEntries->entries.size() : 0;
+    m_stats = Stats();
+    ZeroMemory(m_typeCnt, sizeof(m_typeCnt));
+
+    MakeChunks(runs);
+
+    // Records which span data runs are filtered by the committing thread once whole.
+    MFTRecord splitParser;
+    splitParser.SetRecordInfo(0LL, m_dwRecSize, m_dwBytesPerCluster);
+    splitParser.SetDeferAttrList(DeferAttrLists());
+    splitParser.SetSelect(m_select);
+    RecordFixup splitFixup(m_dwRecSize, m_bytesPerSector);
+    m_pSplitParser = &splitParser;
+    m_pSplitFixup = &splitFixup;
+    m_splitRecord.clear();
+    m_splitRecords = m_splitKept = 0;
+
+    ReadPlan readPlan(max(m_config.maxRequest, m_config.chunkSize), m_config.maxGap, m_config.sortByLCN);
+    readPlan.Build(m_chunks);
+    m_pPlan = &readPlan;
+    m_stats.requests = readPlan.Requests().size();
+    m_stats.gapBytes = readPlan.GapBytes();
+
+    int nRet;
+    if (!filter.IsValid() && m_pSink == NULL && m_pOutEntries == NULL)
+        nRet = LoadUnfiltered(*pOutMFT);
+    else if (m_config.workers == 0)
+        nRet = LoadSerial();
+    else
+        nRet = LoadPipelined();
+
+    m_stats.records += m_splitRecords;
+    m_stats.kept += m_splitKept;
+    AddTypeCnts(splitParser);
+    AddFixupCounts(splitFixup);
+    m_pSplitParser = NULL;
+    m_pSplitFixup = NULL;
+
+    // Entries with an $ATTRIBUTE_LIST were kept unfiltered, all extension records are 
+    // now known. Merge them and filter those entries.
+    if (nRet == ERROR_SUCCESS && DeferAttrLists())
+    {
+        pOutEntries->FilterAttrLists(filter, entryBegin, &m_targets);
+        m_stats.kept = pOutEntries->entries.size() - entryBegin;
+    }
+
+    m_pPlan = NULL;
+    m_pOutEntries = NULL;
+    m_stats.totalMs = ElapsedMs(start);
+    return nRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Split data runs into chunks of whole records and clusters (both are powers of 2).
+// Units which only hold free records are skipped, contiguous units are merged up to chunkSize.
+// With clusters smaller than records a record may span data runs, each of its parts gets a
+// chunk of its own, see CommitSplit.
+void MFTLoader::MakeChunks(const MFTRecord::FileOnDiskList& runs)
+{
+    DWORD unit = max(m_dwRecSize, m_dwBytesPerCluster);
+    DWORD chunkSize = max(unit, m_config.chunkSize / unit * unit);
+
+    m_chunks.clear();
+    m_splitChunks.clear();
+    m_chunkFirstRec.clear();
+    LONGLONG mftOff = 0;        // MFT byte offset at start of run.
+    for (unsigned runIdx = 0; runIdx < runs.size(); runIdx++)
+    {
+        LONGLONG n64Pos = m_n64StartPos + runs[runIdx].first * m_dwBytesPerCluster;
+        LONGLONG n64Len = runs[runIdx].second;
+
+        // Rest of record begun in earlier run.
+        LONGLONG n64Off = min(n64Len, (LONGLONG)((m_dwRecSize - mftOff % m_dwRecSize) % m_dwRecSize));
+        if (n64Off != 0)
+            AddSplitChunk(n64Pos, (DWORD)n64Off, mftOff / m_dwRecSize);
+
+        LONGLONG n64End = n64Off + (n64Len - n64Off) / m_dwRecSize * m_dwRecSize;
+        while (n64Off < n64End)
+        {
+            DWORD unitLen = (DWORD)min((LONGLONG)unit, n64End - n64Off);
+            if (!IsInUse((mftOff + n64Off) / m_dwRecSize, unitLen / m_dwRecSize))
+            {
+                m_stats.bytesSkipped += unitLen;
+            }
+            else if (!m_chunks.empty() && !m_splitChunks.back()
+                && m_chunks.back().pos + m_chunks.back().len == n64Pos + n64Off
+                && m_chunks.back().len + unitLen <= chunkSize)
+            {
+                m_chunks.back().len += unitLen;
+            }
+            else
+            {
+                ReadPlan::Extent chunk;
+                chunk.pos = n64Pos + n64Off;
+                chunk.len = unitLen;
+                m_chunks.push_back(chunk);
+                m_splitChunks.push_back(false);
+                m_chunkFirstRec.push_back((DWORD)((mftOff + n64Off) / m_dwRecSize));
+            }
+            n64Off += unitLen;
+        }
+
+        // Start of record continued in next run.
+        if (n64End < n64Len)
+            AddSplitChunk(n64Pos + n64End, (DWORD)(n64Len - n64End), (mftOff + n64End) / m_dwRecSize);
+        mftOff += n64Len;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Add chunk holding part of record recIdx, which spans data runs.
+void MFTLoader::AddSplitChunk(LONGLONG n64Pos, DWORD len, LONGLONG recIdx)
+{
+    if (!IsInUse(recIdx, 1))
+    {
+        m_stats.bytesSkipped += len;
+        return;
+    }
+
+    ReadPlan::Extent chunk;
+    chunk.pos = n64Pos;
+    chunk.len = len;
+    m_chunks.push_back(chunk);
+    m_splitChunks.push_back(true);
+    m_chunkFirstRec.push_back((DWORD)recIdx);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Return true if any of the records is marked in use, or there is no bitmap.
+// Records past end of bitmap have never been used.
+bool MFTLoader::IsInUse(LONGLONG firstRec, DWORD recCnt) const
+{
+    if (m_bitmap.size() == 0)
+        return true;
+
+    const BYTE* pBits = (const BYTE*)m_bitmap.OutVPtr(0);
+    for (LONGLONG rec = firstRec; rec < firstRec + recCnt; rec++)
+    {
+        if ((size_t)(rec >> 3) >= m_bitmap.size())
+            return false;
+        if ((pBits[rec >> 3] & (1 << (rec & 7))) != 0)
+            return true;
+    }
+    return false;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Read one request (one or more chunks and the gaps between them).
+// Return 0 on success, else last error.
+DWORD MFTLoader::ReadRequest(const ReadPlan::Request& request, BYTE* pDst, DWORD& outLen)
+{
+    DWORD error = ReadPlan::ReadRequest(*m_pReader, request, pDst, outLen);
+    if (error == ERROR_SUCCESS && outLen == 0)
+        error = ERROR_HANDLE_EOF;
+    return error;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Return bytes of piece which were read, trimmed to whole MFT records. Parts of split
+// records are all or nothing.
+DWORD MFTLoader::PieceLength(const ReadPlan::Piece& piece, DWORD readLen) const
+{
+    if (readLen <= piece.offset)
+        return 0;
+    DWORD len = min(m_chunks[piece.extentIdx].len, readLen - piece.offset);
+    if (m_splitChunks[piece.extentIdx])
+        return (len == m_chunks[piece.extentIdx].len) ? len : 0;
+    return len - len % m_dwRecSize;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Fix and filter each piece of slot in place, return 0 on success, else last error.
+DWORD MFTLoader::FilterRequest(MFTRecord& mftRecord, RecordFixup& fixup, Slot& slot, LONGLONG& records)
+{
+    const ReadPlan::Request& request = m_pPlan->Requests()[slot.reqIdx];
+    slot.kept.resize(request.pieces.size());
+    slot.dirs.resize(request.pieces.size());
+    slot.entries.resize(request.pieces.size());
+    bool wantEntries = (m_pSink != NULL || m_pOutEntries != NULL);
+
+    for (unsigned pieceIdx = 0; pieceIdx < request.pieces.size(); pieceIdx++)
+    {
+        const ReadPlan::Piece& piece = request.pieces[pieceIdx];
+        DWORD dwLen = PieceLength(piece, slot.len);
+        if (dwLen == 0)
+            return ERROR_HANDLE_EOF;
+
+        slot.dirs[pieceIdx].clear();
+        slot.entries[pieceIdx].clear();
+        if (m_splitChunks[piece.extentIdx])
+        {
+            slot.kept[pieceIdx] = dwLen;    // Kept as is until whole, see CommitSplit.
+            continue;
+        }
+
+        if (m_bytesPerSector != 0)
+            fixup.Apply(slot.data.Data() + piece.offset, dwLen);
+
+        slot.kept[pieceIdx] = mftRecord.FilterRecords(slot.data.Data() + piece.offset, dwLen, 
+            m_chunkFirstRec[piece.extentIdx], *m_pFilter, 
+            (m_pSink != NULL || m_pDirTable != NULL) ? &slot.dirs[pieceIdx] : NULL, 
+            wantEntries ? &slot.entries[pieceIdx] : NULL, &m_targets);
+        records += dwLen / m_dwRecSize;
+    }
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Commit pieces of slot in chunk (VCN) order. Pieces which are ahead of the next chunk 
+// are moved to m_pending, pending chunks are committed once their turn arrives.
+DWORD MFTLoader::CommitRequest(Slot& slot)
+{
+    const ReadPlan::Request& request = m_pPlan->Requests()[slot.reqIdx];
+    for (unsigned pieceIdx = 0; pieceIdx < request.pieces.size(); pieceIdx++)
+    {
+        const ReadPlan::Piece& piece = request.pieces[pieceIdx];
+        BYTE* pData = slot.data.Data() + piece.offset;
+        if (piece.extentIdx != m_nextCommit)
+        {
+            Pending& pending = m_pending[piece.extentIdx];
+            if (WantRecords(piece.extentIdx))
+                pending.data.assign(pData, pData + slot.kept[pieceIdx]);
+            pending.dirs.swap(slot.dirs[pieceIdx]);
+            std::swap(pending.entries, slot.entries[pieceIdx]);
+            continue;
+        }
+
+        DWORD error = CommitChunk(piece.extentIdx, slot.dirs[pieceIdx], slot.entries[pieceIdx], pData, slot.kept[pieceIdx]);
+        if (error != ERROR_SUCCESS)
+            return error;
+        m_nextCommit++;
+
+        std::map<size_t, Pending>::iterator iter;
+        while ((iter = m_pending.find(m_nextCommit)) != m_pending.end())
+        {
+            error = CommitChunk(iter->first, iter->second.dirs, iter->second.entries, iter->second.data.Data(), (DWORD)iter->second.data.size());
+            if (error != ERROR_SUCCESS)
+                return error;
+            m_pending.erase(iter);
+            m_nextCommit++;
+        }
+    }
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Move filtered pieces of slot to m_pending, so the slot is reused before they are committed.
+// Record bytes are copied only if wanted, see WantRecords. Caller holds m_lock.
+void MFTLoader::PendRequest(Slot& slot)
+{
+    const ReadPlan::Request& request = m_pPlan->Requests()[slot.reqIdx];
+    for (unsigned pieceIdx = 0; pieceIdx < request.pieces.size(); pieceIdx++)
+    {
+        const ReadPlan::Piece& piece = request.pieces[pieceIdx];
+        const BYTE* pData = slot.data.Data() + piece.offset;
+        Pending& pending = m_pending[piece.extentIdx];
+        if (WantRecords(piece.extentIdx))
+            pending.data.assign(pData, pData + slot.kept[pieceIdx]);
+        pending.dirs.swap(slot.dirs[pieceIdx]);
+        std::swap(pending.entries, slot.entries[pieceIdx]);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Commit pending chunks in chunk order. One worker at a time takes the chunks which are next
+// out of m_pending and commits them with m_lock released, so the sink runs while the other 
+// workers filter. Caller holds lock, return 0 on success, else last error.
+DWORD MFTLoader::CommitReady(std::unique_lock<std::mutex>& lock)
+{
+    if (m_committing)
+        return ERROR_SUCCESS;       // Committing worker takes chunks pended meanwhile.
+
+    m_committing = true;
+    DWORD error = ERROR_SUCCESS;
+    std::vector<Pending> ready;
+    while (error == ERROR_SUCCESS && m_error == ERROR_SUCCESS)
+    {
+        size_t firstReady = m_nextCommit;
+        std::map<size_t, Pending>::iterator iter;
+        while ((iter = m_pending.find(m_nextCommit)) != m_pending.end())
+        {
+            ready.push_back(Pending());
+            Pending& next = ready.back();
+            next.data.swap(iter->second.data);
+            next.dirs.swap(iter->second.dirs);
+            std::swap(next.entries, iter->second.entries);
+            m_pending.erase(iter);
+            m_nextCommit++;
+        }
+        if (ready.empty())
+            break;
+
+        lock.unlock();
+        m_commitDone.notify_all();
+        for (size_t readyIdx = 0; readyIdx < ready.size() && error == ERROR_SUCCESS; readyIdx++)
+        {
+            Pending& next = ready[readyIdx];
+            error = CommitChunk(firstReady + readyIdx, next.dirs, next.entries, next.data.Data(), (DWORD)next.data.size());
+        }
+        ready.clear();
+        lock.lock();
+    }
+    m_committing = false;
+    m_commitDone.notify_all();
+    return error;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Commit chunk chunkIdx, called in chunk order.
+DWORD MFTLoader::CommitChunk(size_t chunkIdx, const DirTable::EntryList& dirs, const MFTEntryList& entries, BYTE* pData, DWORD len)
+{
+    if (m_splitChunks[chunkIdx])
+        return CommitSplit(chunkIdx, pData, len);
+    return Commit(dirs, entries, pData, len);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Collect the parts of a record which spans data runs, once whole fix, filter and commit it.
+DWORD MFTLoader::CommitSplit(size_t chunkIdx, const BYTE* pData, DWORD len)
+{
+    m_splitRecord.insert(m_splitRecord.end(), pData, pData + len);
+    if (m_splitRecord.size() < m_dwRecSize)
+        return ERROR_SUCCESS;
+
+    if (m_bytesPerSector != 0)
+        m_pSplitFixup->Apply(m_splitRecord.Data(), m_dwRecSize);
+
+    DirTable::EntryList dirs;
+    MFTEntryList entries;
+    bool wantEntries = (m_pSink != NULL || m_pOutEntries != NULL);
+    DWORD kept = m_pSplitParser->FilterRecords(m_splitRecord.Data(), m_dwRecSize, m_chunkFirstRec[chunkIdx], *m_pFilter, 
+        (m_pSink != NULL || m_pDirTable != NULL) ? &dirs : NULL, wantEntries ? &entries : NULL, &m_targets);
+    m_splitRecords++;
+    m_splitKept += kept / m_dwRecSize;
+
+    DWORD error = Commit(dirs, entries, m_splitRecord.Data(), kept);
+    m_splitRecord.clear();
+    return error;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Pass filtered chunk to sink or append it to output, called in chunk order.
+DWORD MFTLoader::Commit(const DirTable::EntryList& dirs, const MFTEntryList& entries, BYTE* pData, DWORD len)
+{
+    if (m_pDirTable != NULL)
+        m_pDirTable->Add(dirs);
+    if (m_pSink != NULL)
+        return m_pSink->OnRecords(dirs, entries, pData, len);
+
+    if (m_pOutMFT != NULL)
+        m_pOutMFT->insert(m_pOutMFT->end(), pData, pData + len);
+    if (m_pOutEntries != NULL)
+        m_pOutEntries->Append(entries);
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+void MFTLoader::AddTypeCnts(const MFTRecord& mftRecord)
+{
+    for (unsigned mftRecIdx = 1; mftRecIdx < 16; mftRecIdx++)
+        m_typeCnt[mftRecIdx] += mftRecord.GetTypeCnts()[mftRecIdx];
+}
+
+// ------------------------------------------------------------------------------------------------
+void MFTLoader::AddFixupCounts(const RecordFixup& fixup)
+{
+    m_stats.badRecords += fixup.GetCounts().bad;
+    m_stats.tornRecords += fixup.GetCounts().torn;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Without a filter there is nothing to parse, read directly into output. Requests arrive
+// in disk order, each piece is copied to its chunk's offset in the output and fixed there.
+int MFTLoader::LoadUnfiltered(Buffer& outMFT)
+{
+    const ReadPlan::RequestList& requests = m_pPlan->Requests();
+
+    std::vector<size_t> chunkOffsets(m_chunks.size());
+    size_t n64Total = 0;
+    for (unsigned chunkIdx = 0; chunkIdx < m_chunks.size(); chunkIdx++)
+    {
+        chunkOffsets[chunkIdx] = n64Total;
+        n64Total += m_chunks[chunkIdx].len;
+    }
+
+    size_t begSize = outMFT.size();
+    outMFT.resize(begSize + n64Total);
+    size_t outSize = begSize + n64Total;     // Trimmed at first short chunk.
+
+    // Completions arrive in submit order, so request buffers are reused round robin.
+    AsyncReader asyncReader(*m_pReader, m_config.queueDepth);
+    m_stats.queueDepth = asyncReader.QueueDepth();
+    std::vector<AlignedBuffer> reqBuffers(asyncReader.QueueDepth());
+    RecordFixup fixup(m_dwRecSize, m_bytesPerSector);
+
+    size_t nextReq = 0;
+    Clock::time_point start = Clock::now();
+    while (nextReq < requests.size() || asyncReader.Pending() != 0)
+    {
+        DWORD error;
+        if (nextReq < requests.size() && !asyncReader.IsFull())
+        {
+            const ReadPlan::Request& request = requests[nextReq];
+            BYTE* pDst = outMFT.Data() + begSize + chunkOffsets[request.pieces[0].extentIdx];
+            if (request.pieces.size() != 1)
+            {
+                AlignedBuffer& reqBuffer = reqBuffers[nextReq % reqBuffers.size()];
+                reqBuffer.resize(request.len);
+                pDst = reqBuffer.Data();
+            }
+            error = asyncReader.Submit(request.pos, pDst, request.len, nextReq++);
+        }
+        else
+        {
+            AsyncReader::Completion done;
+            error = asyncReader.Wait(done);
+            if (error == ERROR_SUCCESS && done.outLen == 0)
+                error = ERROR_HANDLE_EOF;
+            if (error == ERROR_SUCCESS)
+            {
+                const ReadPlan::Request& request = requests[done.tag];
+                m_stats.bytesRead += done.outLen;
+
+                for (unsigned pieceIdx = 0; pieceIdx < request.pieces.size(); pieceIdx++)
+                {
+                    const ReadPlan::Piece& piece = request.pieces[pieceIdx];
+                    DWORD dwLen = PieceLength(piece, done.outLen);
+                    size_t outOff = begSize + chunkOffsets[piece.extentIdx];
+                    if (request.pieces.size() != 1)
+                        memcpy(outMFT.Data() + outOff, done.pDst + piece.offset, dwLen);
+                    if (m_bytesPerSector != 0)
+                        fixup.Apply(outMFT.Data() + outOff, dwLen);
+                    if (dwLen < m_chunks[piece.extentIdx].len)
+                        outSize = min(outSize, outOff + dwLen);
+                }
+            }
+        }
+
+        if (error != ERROR_SUCCESS)
+        {
+            asyncReader.Drain();
+            outMFT.resize(begSize);
+            return error;
+        }
+    }
+
+    // Parts of split records are in place, fix the records now they are whole.
+    DWORD splitLen = 0;
+    for (unsigned chunkIdx = 0; chunkIdx < m_chunks.size(); chunkIdx++)
+    {
+        if (!m_splitChunks[chunkIdx])
+            continue;
+        splitLen += m_chunks[chunkIdx].len;
+        if (splitLen < m_dwRecSize)
+            continue;
+        size_t recOff = begSize + chunkOffsets[chunkIdx] + m_chunks[chunkIdx].len - m_dwRecSize;
+        if (m_bytesPerSector != 0 && recOff + m_dwRecSize <= outSize)
+            fixup.Apply(outMFT.Data() + recOff, m_dwRecSize);
+        splitLen = 0;
+    }
+
+    outSize = begSize + (outSize - begSize) / m_dwRecSize * m_dwRecSize;
+    outMFT.resize(outSize);
+
+    m_stats.readMs = ElapsedMs(start);
+    m_stats.records = m_stats.kept = (outSize - begSize) / m_dwRecSize;
+    AddFixupCounts(fixup);
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Read request then filter it, one at a time on calling thread.
+int MFTLoader::LoadSerial()
+{
+    MFTRecord mftRecord;
+    mftRecord.SetRecordInfo(0LL, m_dwRecSize, m_dwBytesPerCluster);
+    mftRecord.SetDeferAttrList(DeferAttrLists());
+    mftRecord.SetSelect(m_select);
+    RecordFixup fixup(m_dwRecSize, m_bytesPerSector);
+
+    m_nextCommit = 0;
+    m_pending.clear();
+
+    Slot slot;
+    slot.data.resize(m_pPlan->MaxLength());
+    for (slot.reqIdx = 0; slot.reqIdx < m_pPlan->Requests().size(); slot.reqIdx++)
+    {
+        Clock::time_point start = Clock::now();
+        DWORD error = ReadRequest(m_pPlan->Requests()[slot.reqIdx], slot.data.Data(), slot.len);
+        m_stats.readMs += ElapsedMs(start);
+        if (error != ERROR_SUCCESS)
+            return error;
+        m_stats.bytesRead += slot.len;
+
+        start = Clock::now();
+        error = FilterRequest(mftRecord, fixup, slot, m_stats.records);
+        m_stats.parseMs += ElapsedMs(start);
+        if (error == ERROR_SUCCESS)
+            error = CommitRequest(slot);
+        if (error != ERROR_SUCCESS)
+            return error;
+
+        for (unsigned pieceIdx = 0; pieceIdx < slot.kept.size(); pieceIdx++)
+            m_stats.kept += slot.kept[pieceIdx] / m_dwRecSize;
+    }
+
+    m_pending.clear();
+    AddTypeCnts(mftRecord);
+    AddFixupCounts(fixup);
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Calling thread queues reads of requests into free slots, workers (ParseStage) filter 
+// full slots, pend their pieces and return the slot to the free list. Pieces are committed
+// in chunk order by one worker at a time, see CommitReady.
+int MFTLoader::LoadPipelined()
+{
+    AsyncReader asyncReader(*m_pReader, m_config.queueDepth);
+    bool threadSafe = m_pFilter->IsThreadSafe();
+    for (unsigned targetIdx = 0; targetIdx < m_targets.size(); targetIdx++)
+        threadSafe &= m_targets[targetIdx]->IsThreadSafe();
+    unsigned workers = threadSafe ? m_config.workers : 1;
+    unsigned buffers = (m_config.buffers != 0) ? max(m_config.buffers, 2u) : workers + asyncReader.QueueDepth() + 1;
+    m_stats.workers = workers;
+    m_stats.queueDepth = asyncReader.QueueDepth();
+
+    m_slots.resize(buffers);
+    m_freeSlots.clear();
+    m_fullSlots.clear();
+    for (unsigned slotIdx = 0; slotIdx < buffers; slotIdx++)
+    {
+        m_slots[slotIdx].data.resize(m_pPlan->MaxLength());
+        m_freeSlots.push_back(slotIdx);
+    }
+    m_nextCommit = 0;
+    m_pending.clear();
+    m_committing = false;
+    m_readDone = false;
+    m_error = ERROR_SUCCESS;
+
+    std::vector<std::thread> threads;
+    for (unsigned workerIdx = 0; workerIdx < workers; workerIdx++)
+        threads.push_back(std::thread(&MFTLoader::ParseStage, this));
+
+    // Keep reads in flight while free slots are available, else complete the oldest read
+    // and hand it to the workers.
+    const ReadPlan::RequestList& requests = m_pPlan->Requests();
+    size_t nextReq = 0;
+    while (nextReq < requests.size() || asyncReader.Pending() != 0)
+    {
+        if (nextReq < requests.size() && !asyncReader.IsFull())
+        {
+            unsigned slotIdx = 0;
+            bool haveSlot = false;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                if (asyncReader.Pending() == 0)
+                    m_slotFree.wait(lock, [this] { return !m_freeSlots.empty() || m_error != ERROR_SUCCESS; });
+                if (m_error != ERROR_SUCCESS)
+                    break;
+                if (!m_freeSlots.empty())
+                {
+                    haveSlot = true;
+                    slotIdx = m_freeSlots.front();
+                    m_freeSlots.pop_front();
+                }
+            }
+
+            if (haveSlot)
+            {
+                Slot& slot = m_slots[slotIdx];
+                slot.reqIdx = nextReq;
+                const ReadPlan::Request& request = requests[nextReq++];
+                DWORD error = asyncReader.Submit(request.pos, slot.data.Data(), request.len, slotIdx);
+                if (error != ERROR_SUCCESS)
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_error = error;
+                    m_freeSlots.push_back(slotIdx);
+                    break;
+                }
+                continue;
+            }
+        }
+
+        AsyncReader::Completion done;
+        Clock::time_point start = Clock::now();
+        DWORD error = asyncReader.Wait(done);
+        double readMs = ElapsedMs(start);
+
+        unsigned slotIdx = (unsigned)done.tag;
+        Slot& slot = m_slots[slotIdx];
+        slot.len = done.outLen;
+        if (error == ERROR_SUCCESS && slot.len == 0)
+            error = ERROR_HANDLE_EOF;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stats.readMs += readMs;
+            if (error != ERROR_SUCCESS || m_error != ERROR_SUCCESS)
+            {
+                if (m_error == ERROR_SUCCESS)
+                    m_error = error;
+                m_freeSlots.push_back(slotIdx);
+                break;
+            }
+            m_stats.bytesRead += slot.len;
+            m_fullSlots.push_back(slotIdx);
+        }
+        m_slotFull.notify_one();
+    }
+
+    // After an error, reads still in flight own slot buffers.
+    asyncReader.Drain();
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_readDone = true;
+    }
+    m_slotFull.notify_all();
+
+    for (unsigned workerIdx = 0; workerIdx < threads.size(); workerIdx++)
+        threads[workerIdx].join();
+
+    m_slots.clear();
+    m_pending.clear();
+    return m_error;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Worker thread, filter full slots and commit results in chunk order.
+void MFTLoader::ParseStage()
+{
+    MFTRecord mftRecord;
+    mftRecord.SetRecordInfo(0LL, m_dwRecSize, m_dwBytesPerCluster);
+    mftRecord.SetDeferAttrList(DeferAttrLists());
+    mftRecord.SetSelect(m_select);
+    RecordFixup fixup(m_dwRecSize, m_bytesPerSector);
+
+    double parseMs = 0;
+    LONGLONG records = 0;
+    LONGLONG kept = 0;
+
+    for (;;)
+    {
+        unsigned slotIdx;
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_slotFull.wait(lock, [this] { return !m_fullSlots.empty() || m_readDone || m_error != ERROR_SUCCESS; });
+            if (m_fullSlots.empty() || m_error != ERROR_SUCCESS)
+                break;
+            slotIdx = m_fullSlots.front();
+            m_fullSlots.pop_front();
+        }
+
+        Slot& slot = m_slots[slotIdx];
+        Clock::time_point start = Clock::now();
+        DWORD error = FilterRequest(mftRecord, fixup, slot, records);
+        parseMs += ElapsedMs(start);
+        for (unsigned pieceIdx = 0; pieceIdx < slot.kept.size(); pieceIdx++)
+            kept += slot.kept[pieceIdx] / m_dwRecSize;
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            if (m_error == ERROR_SUCCESS)
+                m_error = error;
+            if (m_error == ERROR_SUCCESS)
+                PendRequest(slot);
+            m_freeSlots.push_back(slotIdx);
+            m_slotFree.notify_one();
+
+            if (m_error == ERROR_SUCCESS)
+            {
+                error = CommitReady(lock);
+                if (m_error == ERROR_SUCCESS)
+                    m_error = error;
+            }
+
+            // Hold back while the sink is behind, at most one pending chunk per buffer.
+            m_commitDone.wait(lock, [this] 
+                { return !m_committing || m_pending.size() < m_slots.size() || m_error != ERROR_SUCCESS; });
+        }
+        m_slotFree.notify_one();
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    AddTypeCnts(mftRecord);
+    AddFixupCounts(fixup);
+    m_stats.parseMs += parseMs;
+    m_stats.records += records;
+    m_stats.kept += kept;
+}
@@ -0,0 +1,264 @@
+// ------------------------------------------------------------------------------------------------
+// Pipelined MFT loader, overlap volume reads with MFT record parsing and filtering.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "AsyncReader.h"
+#include "BaseTypes.h"
+#include "FsFilter.h"
+#include "MFTRecord.h"
+#include "ReadPlan.h"
+#include "RecordFixup.h"
+#include "VolumeReader.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+
+// ------------------------------------------------------------------------------------------------
+// Receives MFT chunks in disk order when streaming, see MFTLoader::SetSink.
+class MFTSink
+{
+public:
+    virtual ~MFTSink()
+    { }
+
+    // dirs are all in use directories of the chunk (and free ones if selected), pData holds the records which passed 
+    // the filter, with fixups applied (see RecordFixup), entries holds their parsed fields in the same order.
+    // Return 0 to continue, else error to stop the load.
+    virtual DWORD OnRecords(const DirTable::EntryList& dirs, const MFTEntryList& entries, BYTE* pData, DWORD len) = 0;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Load the $MFT data runs into memory, optionally removing records which fail a filter.
+//
+// The MFT is split into chunks, ReadPlan merges nearby chunks into larger reads issued in
+// disk (LCN) order. The calling thread keeps up to queueDepth reads in flight (AsyncReader)
+// into a small ring of buffers while worker threads parse and filter full buffers. 
+// Filtered chunks are appended to the output in MFT (VCN) order, so the result is 
+// identical to a serial load. This is where a scan parses in parallel (-j), reports
+// only walk the catalog built here.
+//
+//  Ex:
+//      MFTLoader loader(pReader, n64StartPos, 1024, 4096);
+//      loader.Load(mftRecord.m_fileOnDisk, filter, copyOfMFT);
+
+class MFTLoader
+{
+public:
+    struct Config
+    {
+        Config() :
+            workers(DefaultWorkers()), buffers(0), chunkSize(1 << 20), 
+            maxRequest(4 << 20), maxGap(256 << 10), sortByLCN(true), queueDepth(4)
+        { }
+
+        unsigned    workers;        // Parse/filter threads, 0 = read then parse on calling thread.
+        unsigned    buffers;        // Read buffers in ring, 0 = workers + queueDepth + 1.
+        DWORD       chunkSize;      // Bytes per chunk, rounded to whole records and clusters.
+        DWORD       maxRequest;     // Largest read when merging chunks, see ReadPlan.
+        DWORD       maxGap;         // Largest hole read over when merging chunks.
+        bool        sortByLCN;      // Issue reads in disk order, else MFT order (streaming).
+        unsigned    queueDepth;     // Reads in flight, see AsyncReader.
+    };
+
+    struct Stats
+    {
+        Stats() :
+            bytesRead(0), bytesSkipped(0), gapBytes(0), requests(0), records(0), kept(0),
+            badRecords(0), tornRecords(0),
+            readMs(0), parseMs(0), totalMs(0), workers(0), queueDepth(0)
+        { }
+
+        LONGLONG    bytesRead;
+        LONGLONG    bytesSkipped;   // Free records not read, see SetBitmap.
+        LONGLONG    gapBytes;       // Bytes read between merged chunks and discarded.
+        LONGLONG    requests;       // Read requests issued.
+        LONGLONG    records;        // MFT records read.
+        LONGLONG    kept;           // MFT records which passed filter.
+        LONGLONG    badRecords;     // Marked "BAAD" or invalid update sequence, see RecordFixup.
+        LONGLONG    tornRecords;    // Sectors from different writes.
+        double      readMs;         // Time reader spent waiting for reads.
+        double      parseMs;        // Time spent parsing and filtering, sum of all workers.
+        double      totalMs;        // Elapsed load time.
+        unsigned    workers;
+        unsigned    queueDepth;
+    };
+
+    MFTLoader(VolumeReader* pReader, LONGLONG n64StartPos, DWORD dwRecSize, DWORD dwBytesPerCluster);
+
+    void SetConfig(const Config& config)
+    { m_config = config; }
+
+    // Optional $MFT:$BITMAP, one bit per record, clusters holding only free records are 
+    // not read. Bitmap is not copied and must outlive Load.
+    void SetBitmap(const Block& bitmap)
+    { m_bitmap = bitmap; }
+
+    // Optional, stream chunks to sink rather than appending them to outMFT, so memory 
+    // use is limited to the read buffers and a filtered copy of each (Config buffers * chunkSize).
+    // Sink is called by one thread at a time, in chunk order, while workers keep filtering.
+    void SetSink(MFTSink* pSink)
+    { m_pSink = pSink; }
+
+    // Sector size from the boot sector, used to check the fixups applied to each record
+    // as it is read. 0 if the source holds records with fixups already applied (snapshot).
+    void SetSectorSize(DWORD bytesPerSector)
+    { m_bytesPerSector = bytesPerSector; }
+
+    // Optional name filters, MFTEntry::targetMask has a bit set per filter matched.
+    // Filters are not copied and must outlive Load.
+    void SetTargets(const MFTRecord::FilterList& targets)
+    { m_targets = targets; }
+
+    // Optional, add the directories of every record parsed, kept or not, to table so paths
+    // are built without reading the MFT again, free ones only if SetSelect has sFree.
+    // Records read unfiltered are not parsed.
+    // Table is not copied and must outlive Load.
+    void SetDirTable(DirTable* pDirTable)
+    { m_pDirTable = pDirTable; }
+
+    // Record classes parsed when filtering, see MFTRecord::SetSelect. Records read 
+    // unfiltered are all kept.
+    void SetSelect(BYTE want)
+    { m_select = want; }
+
+    // Read MFT data runs, list of (disk_LCN, disk_byte_length), and append records which pass 
+    // filter to outMFT. Filters which are not thread safe are run on a single worker.
+    // Return 0 on success, else last error.
+    int Load(const MFTRecord::FileOnDiskList& runs, const FsFilter& filter, Buffer& outMFT);
+
+    // Same, but append the catalog entry of each record which passes filter rather than the
+    // record, so reports need neither keep nor parse the records. Filters test the entries,
+    // extension records are merged into their base record entries first, see 
+    // MFTEntryList::FilterAttrLists.
+    int Load(const MFTRecord::FileOnDiskList& runs, const FsFilter& filter, MFTEntryList& outEntries);
+
+    const Stats& GetStats() const
+    { return m_stats; }
+
+    const MFTRecord::TypeCnt& GetTypeCnts() const
+    { return m_typeCnt; }
+
+    static unsigned DefaultWorkers();
+
+private:
+    struct Slot
+    {
+        AlignedBuffer data;         // Aligned for unbuffered reads.
+        size_t      reqIdx;         // Index in m_pPlan requests.
+        DWORD       len;            // Bytes read.
+        std::vector<DWORD>  kept;   // Kept bytes per piece.
+        std::vector<DirTable::EntryList> dirs;  // Directories per piece.
+        std::vector<MFTEntryList> entries;      // Kept record entries per piece.
+    };
+
+    // Filtered chunk waiting for earlier chunks to be committed.
+    struct Pending
+    {
+        Buffer              data;
+        DirTable::EntryList dirs;
+        MFTEntryList        entries;
+    };
+
+    // Extension records can only be merged once the whole MFT is loaded, not when streaming.
+    bool DeferAttrLists() const
+    { return m_pSink == NULL && m_pOutEntries != NULL; }
+
+    // Kept record bytes are only used by the sink or output buffer, and to join split records.
+    bool WantRecords(size_t chunkIdx) const
+    { return m_pSink != NULL || m_pOutMFT != NULL || m_splitChunks[chunkIdx]; }
+
+    void MakeChunks(const MFTRecord::FileOnDiskList& runs);
+    void AddSplitChunk(LONGLONG n64Pos, DWORD len, LONGLONG recIdx);
+    bool IsInUse(LONGLONG firstRec, DWORD recCnt) const;
+
+    int  LoadTo(const MFTRecord::FileOnDiskList& runs, const FsFilter& filter, Buffer* pOutMFT, 
+        MFTEntryList* pOutEntries);
+    int  LoadUnfiltered(Buffer& outMFT);
+    int  LoadSerial();
+    int  LoadPipelined();
+    void ParseStage();
+
+    DWORD ReadRequest(const ReadPlan::Request& request, BYTE* pDst, DWORD& outLen);
+    DWORD PieceLength(const ReadPlan::Piece& piece, DWORD readLen) const;
+    DWORD FilterRequest(MFTRecord& mftRecord, RecordFixup& fixup, Slot& slot, LONGLONG& records);
+    DWORD CommitRequest(Slot& slot);
+    void  PendRequest(Slot& slot);
+    DWORD CommitReady(std::unique_lock<std::mutex>& lock);
+    DWORD CommitChunk(size_t chunkIdx, const DirTable::EntryList& dirs, const MFTEntryList& entries, BYTE* pData, DWORD len);
+    DWORD CommitSplit(size_t chunkIdx, const BYTE* pData, DWORD len);
+    DWORD Commit(const DirTable::EntryList& dirs, const MFTEntryList& entries, BYTE* pData, DWORD len);
+    void  AddTypeCnts(const MFTRecord& mftRecord);
+    void  AddFixupCounts(const RecordFixup& fixup);
+
+    VolumeReader*   m_pReader;      // Does not own reader.
+    LONGLONG        m_n64StartPos;
+    DWORD           m_dwRecSize;
+    DWORD           m_dwBytesPerCluster;
+    DWORD           m_bytesPerSector;   // 0 = fixups already applied.
+    Config          m_config;
+    Block           m_bitmap;       // $MFT:$BITMAP or empty to read all records.
+    MFTSink*        m_pSink;        // Does not own sink.
+    DirTable*       m_pDirTable;    // Does not own table, NULL if directories are not wanted.
+    MFTRecord::FilterList m_targets;
+    BYTE            m_select;       // RecordClass bits parsed when filtering.
+
+    ReadPlan::ExtentList m_chunks;  // MFT chunks in VCN order.
+    std::vector<bool>   m_splitChunks;  // Per chunk, part of a record which spans data runs.
+    std::vector<DWORD>  m_chunkFirstRec;    // Per chunk, MFT index of its first (or split) record.
+    Buffer              m_splitRecord;  // Parts of split record committed so far.
+    MFTRecord*          m_pSplitParser; // Filters split records once whole, see CommitSplit.
+    RecordFixup*        m_pSplitFixup;
+    LONGLONG            m_splitRecords;
+    LONGLONG            m_splitKept;
+    const ReadPlan*     m_pPlan;
+    const FsFilter*     m_pFilter;
+    Buffer*             m_pOutMFT;      // NULL if records are not wanted.
+    MFTEntryList*       m_pOutEntries;  // NULL if entries are not wanted.
+
+    // Pipeline state, guarded by m_lock.
+    std::mutex              m_lock;
+    std::condition_variable m_slotFree;     // Reader waits for empty buffer.
+    std::condition_variable m_slotFull;     // Workers wait for read buffer.
+    std::condition_variable m_commitDone;   // Workers wait for pending chunks to be committed.
+    std::vector<Slot>       m_slots;
+    std::deque<unsigned>    m_freeSlots;
+    std::deque<unsigned>    m_fullSlots;
+    size_t                  m_nextCommit;   // Next chunk to commit, in VCN order.
+    std::map<size_t, Pending> m_pending;    // Chunks filtered and not committed yet.
+    bool                    m_committing;   // A worker is committing chunks outside m_lock.
+    bool                    m_readDone;
+    DWORD                   m_error;
+
+    Stats               m_stats;
+    MFTRecord::TypeCnt  m_typeCnt;
+};
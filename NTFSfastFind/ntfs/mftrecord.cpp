@@ -33,6 +33,9 @@
 // ------------------------------------------------------------------------------------------------
 
 #include "MFTRecord.h"
+#include "ReadPlan.h"
+#include "RecordFixup.h"
+#include <algorithm>
 #include <assert.h>
 
 char* MFTRecord::sMFTRecordTypeStr[] =
@@ -55,6 +58,9 @@ char* MFTRecord::sMFTRecordTypeStr[] =
     "0xf0"
 };
 
+// Fixed part of $FILE_NAME value, name follows.
+static const DWORD sFileNameOffset = offsetof(MFT_FILEINFO, wFilename);
+
 // ------------------------------------------------------------------------------------------------
 static DWORD ReturnError(DWORD error)
 {
@@ -66,12 +72,17 @@ MFTRecord::MFTRecord() :
     m_bInUse(false),
     m_bSparse(false),
     m_nameCnt(0),
+    m_hardLinks(0),
     m_streamCnt(0),
-    m_fragCnt(0),
-    m_hDrive(INVALID_HANDLE_VALUE),
-    m_dwMFTRecSize(1023),   // usual size
+    m_hasAttrList(false),
+    m_hasSize(false),
+    m_pReader(NULL),
+    m_dwMFTRecSize(1024),   // usual size, 4096 on 4K sector disks
 	m_dwCurPos(0),
-    m_dwBytesPerCluster(0)
+    m_dwBytesPerCluster(0),
+    m_attrListPos(0),
+    m_deferAttrList(false),
+    m_select(RecordClass::sAnyFile)
 {
     ZeroMemory(&m_attrStandard, sizeof(m_attrStandard));
 	ZeroMemory(&m_attrFilename,sizeof(m_attrFilename));
@@ -112,24 +123,24 @@ int MFTRecord::SetRecordInfo(LONGLONG  n64StartPos, DWORD dwRecSize, DWORD dwByt
 
 // ------------------------------------------------------------------------------------------------
 /// inMFTBlock is the MFT record which defines the file to load.
-/// If it points to $MFT, the Master File Table is loaded (loadData==true) and optionally
-/// filtered (pMFTFilter!=NULL)
+/// If it points to $MFT and loadData==true, the Master File Table is loaded unfiltered,
+/// see MFTLoader to load and filter it.
 
 int MFTRecord::ExtractFileOrMFT(
         const Block& inMFTBlock, bool loadData, size_t maxSize, 
-        const FsFilter* pMFTFilter,
         const StreamFilter* pStreamFilter)
 {
 	if (inMFTBlock.size() < m_dwMFTRecSize)
 		return ReturnError(ERROR_INVALID_PARAMETER);
 
 	int nRet;
-	
+    const BYTE* pValue;
+    DWORD nameLen;
+
     // If 'loadData' is true, the files contents are stroed in m_outFileData.
     m_MFTBlock   = inMFTBlock;
 	m_dwCurPos   = 0;
     m_outFileData.resize(0);
-    Buffer tmpBuffer;
 
 	// read the record header in MFT table
 	const MFT_FILE_HEADER* pNtfsMFT = m_MFTBlock.OutPtr<MFT_FILE_HEADER>(0);
@@ -141,62 +152,29 @@ int MFTRecord::ExtractFileOrMFT(
 	m_bInUse = (pNtfsMFT->wFlags & 0x01);   // mask 0x01  Record is in use
 									        // mask 0x02  Record is a directory
     m_bSparse = false;
-    m_fragCnt = 0;
-
-    /*
-    http://hetmanrecovery.com/file_system/ntfs_recovery/ntfs_mft.htm
-
-    NTFS incorporates fixup values into data structures that are over one sector in length. With fixup values,
-    the last two bytes of each sector in large data structures are replaced with a signature value when the 
-    data structure is written to disk. The signature is later used to verify the integrity of the data by 
-    verifying that all sectors have the same signature. Note that fixups are used only in data structures 
-    and not in sectors that contain file content.
-
-    The data structures that use fixups have header fields that identify the current 16-bit signature value 
-    and an array that contains the original values. When the data structure is written to disk, the signature 
-    value is incremented by one, the last two bytes of each sector are copied to the array, and the signature 
-    value is written to the last two bytes of each sector. When reading the data structure, the OS should 
-    verify that the last two bytes of each sector are equal to the signature value, and the original values 
-    are then replaced from the array.
-
-    Fixups are used to detect damaged sectors and corrupt data structures. If only one sector of a multi-sector 
-    data structure was written, the fixup will be different from the signature, and the OS will know that 
-    the data are corrupt. When we dissect our example file system, we will need to 
-    */
-
-    WORD  fixSize = pNtfsMFT->wFixupSize;
-    if (fixSize != 0)
-    {
-        const WORD* pFixUp =  m_MFTBlock.OutPtr<WORD>(pNtfsMFT->wFixupOffset);
-        const WORD sig = *pFixUp++;
-        fixSize--;
-        WORD* pData = (WORD*)pNtfsMFT + 256-1;
-        while (fixSize-- != 0)
-        {
-            // assert(*pData == sig);
-            *pData = *pFixUp++;
-            pData += 256;
-        }
-    }
+    m_frag = FragInfo();
+    m_hasAttrList = false;
+    m_hasSize = false;
 
-	m_dwCurPos = pNtfsMFT->wAttribOffset;
+    // Fixups were applied when the record was read, see RecordFixup.
 
+    // Attributes not found in this record (ex: extension record) must not keep values
+    // of the previous record.
+    ZeroMemory(&m_attrStandard, sizeof(m_attrStandard));
+    ZeroMemory(&m_attrFilename, sFileNameOffset);
+    m_attrFilename.wFilename[0] = 0;
     m_nameCnt   = 0;
     m_streamCnt = 0;
+    m_names.clear();
+    m_namePool.clear();
+    m_hardLinks = pNtfsMFT->wHardLinks;
 
-    const NTFS_ATTRIBUTE* pNtfsAttr = NULL;
-
-	do
-	{	// Extract the attribute header, only the first field is required.
-        try
-        {
-	        pNtfsAttr = m_MFTBlock.OutPtr<NTFS_ATTRIBUTE>(m_dwCurPos, sizeof(pNtfsAttr->dwType));
-        } 
-        catch (const BlockException&)
-        {
-            // TODO - how should we deal with this error ?
-			return ERROR_SUCCESS;
-        }
+    // Attributes are used in place, a bad header ends the walk.
+    AttrIter attrIter(m_MFTBlock, pNtfsMFT->wAttribOffset);
+	for (; attrIter.IsValid(); attrIter.Next())
+	{
+        const NTFS_ATTRIBUTE* pNtfsAttr = &*attrIter;
+        m_dwCurPos = attrIter.Offset();
 
         /*
 
@@ -228,35 +206,49 @@ int MFTRecord::ExtractFileOrMFT(
 		case 0: //UNUSED
 			break;
 
-		case 0x10: // STANDARD_INFORMATION
-	        memset(&m_attrStandard, 0, sizeof(MFT_STANDARD ));
-            tmpBuffer.clear();
-			nRet = ExtractData(*pNtfsAttr, tmpBuffer, 512);
-			if (nRet)
-				return nRet;
-            if (tmpBuffer.size() < sizeof(m_attrStandard))
+		case 0x10: // STANDARD_INFORMATION, always resident.
+            pValue = attrIter.Value(sizeof(m_attrStandard));
+            if (pValue == NULL)
             {
-                std::wcout << "Error Attribute bufferSize=" << tmpBuffer.size() << " expect min size of " << sizeof(m_attrStandard) << std::endl;
+                std::wcout << "Error Attribute bufferSize=" << attrIter.ValueLength() << " expect min size of " << sizeof(m_attrStandard) << std::endl;
                 return ReturnError(ERROR_INVALID_PARAMETER);
             }
-            memcpy(&m_attrStandard, &tmpBuffer[0], min(tmpBuffer.size(), sizeof(m_attrStandard)));
+            memcpy(&m_attrStandard, pValue, sizeof(m_attrStandard));
 			break;
 
-		case 0x30: // FILE_NAME
-	        memset(&m_attrFilename, 0, sizeof(MFT_FILEINFO));
-            tmpBuffer.clear();
-			nRet = ExtractData(*pNtfsAttr, tmpBuffer, 4096);
-			if (nRet)
-				return nRet;
+		case 0x20: // ATTRIBUTE_LIST, see GetAttrList.
+            m_hasAttrList = true;
+            m_attrListPos = attrIter.Offset();
+            break;
 
-            if (tmpBuffer.size() < sizeof(m_attrFilename) - sizeof(m_attrFilename.wFilename))
+		case 0x30: // FILE_NAME, always resident.
+            pValue = attrIter.Value(sFileNameOffset);
+            if (pValue == NULL)
                 return ReturnError(ERROR_INVALID_PARAMETER);
-            
-            memcpy(&m_attrFilename, &tmpBuffer[0], min(tmpBuffer.size(), sizeof(m_attrFilename)));
-          
-            if (m_attrFilename.chFileNameLength < ARRAYSIZE(m_attrFilename.wFilename))
-                m_attrFilename.wFilename[m_attrFilename.chFileNameLength] = 0;
+
+            {
+            const MFT_FILEINFO* pName = (const MFT_FILEINFO*)pValue;
+            nameLen = min((DWORD)pName->chFileNameLength, 
+                (attrIter.ValueLength() - sFileNameOffset) / (DWORD)sizeof(wchar_t));
+
+            // Every name is kept, record shows its preferred name whatever the attribute order.
+            NameRef nameRef;
+            nameRef.parentRef  = pName->dwMftParentDir;
+            nameRef.nameOffset = (DWORD)m_namePool.size();
+            nameRef.nameLen    = (BYTE)nameLen;
+            nameRef.nameType   = pName->chFileNameType;
+            m_names.push_back(nameRef);
+            m_namePool.insert(m_namePool.end(), pName->wFilename, pName->wFilename + nameLen);
+
+            // Copy fixed part and name only, name is terminated for the filters.
+            if (m_nameCnt == 0 || NameRank(pName->chFileNameType) > NameRank(m_attrFilename.chFileNameType))
+            {
+                memcpy(&m_attrFilename, pValue, sFileNameOffset + nameLen * sizeof(wchar_t));
+                m_attrFilename.chFileNameLength = (BYTE)nameLen;
+                m_attrFilename.wFilename[nameLen] = 0;
+            }
             m_nameCnt++;
+            }
 			break;
 
 		case 0x40: // OBJECT_ID
@@ -268,11 +260,19 @@ int MFTRecord::ExtractFileOrMFT(
 		case 0x70: // VOLUME_INFORMATION
 			break;
 		case 0x80: // DATA
+            if (pNtfsAttr->uchNonResFlag && pNtfsAttr->Attr.NonResident.n64StartVCN != 0)
+            {
+                // Later segment of a $DATA split over several records (see $ATTRIBUTE_LIST),
+                // the stream and its sizes are counted from its first segment.
+                DataRun::Decode(*pNtfsAttr, m_dwBytesPerCluster, m_fileOnDisk.empty() ? &m_fileOnDisk : NULL, &m_frag);
+                m_bSparse |= (m_frag.sparseRuns != 0);
+                break;
+            }
             m_streamCnt++;
             if (loadData)
             {
                 // Append to buffer
-			    nRet = ExtractData(*pNtfsAttr, m_outFileData, maxSize, pMFTFilter);
+			    nRet = ExtractData(*pNtfsAttr, m_outFileData, maxSize);
 		     	if (nRet)
 		    		return nRet;
             }
@@ -298,69 +298,14 @@ int MFTRecord::ExtractFileOrMFT(
 
                     // NonResidence file data.
                     // Get actual 'data' size from this chunk of resident file data.
-		            LONGLONG realSize = pNtfsAttr->Attr.NonResident.n64RealSize;
                     m_attrFilename.n64DiskSize = pNtfsAttr->Attr.NonResident.n64AllocSize;
                     m_attrFilename.n64FileSize = pNtfsAttr->Attr.NonResident.n64RealSize;
+                    m_hasSize = true;
 
-			        if (m_fileOnDisk.empty())
-                        ExtractDataPos(*pNtfsAttr, m_outFileData, maxSize, pMFTFilter);
-
-                    if (pNtfsAttr->Attr.NonResident.wDatarunOffset != 0)
-                    {
-                        // Sparse file have data runs (I think)
-                        //
-                        // DataRuns    [[OL] [DataSize...] [Offset...] ]...
-                        //  First byte, low nibble is byte length of DataSize value
-                        //              high nibble is byte length of Offset value
-                        //  Repeat until OL is zero.
-                        // ( [LengthOfSizes] [DataSize] [Offset] ) ... repeat until LengthOfSizes is zero.
-                        const BYTE* pRunList = (const BYTE*)pNtfsAttr + pNtfsAttr->Attr.NonResident.wDatarunOffset;
-
-#if 1
-                        // Parse allocation list and count fragments and flag sparse files.
-                        m_fragCnt = 0;
-                        m_bSparse = false;
-                        DWORD64 totalSize = 0;
-
-                        while (*pRunList != 0)
-                        {
-                            unsigned char dataSizeLen = pRunList[0] & 0x0f;   
-                            unsigned char offsetLen   = (pRunList[0] & 0xf0) >> 4;
-
-                            m_bSparse |= (offsetLen == 0);     // Sparse if no offset.
-
-                            pRunList++;
-                            DWORD64 dataSize = 0;
-                            unsigned byteIdx = 0;
-                            while (dataSizeLen-- != 0)
-                            {
-                                ((BYTE*)&dataSize)[byteIdx++] = *pRunList++;
-                            }
-                            DWORD64 offset = 0;
-                            byteIdx = 0;
-                            while (offsetLen-- != 0)
-                            {
-                                ((BYTE*)&offset)[byteIdx++] = *pRunList++;
-
-                            }
-
-                            if (offset != 0)
-                                m_fragCnt++;
-
-                            totalSize += dataSize;
-                            // std::wcout << m_attrFilename.wFilename << " offset=" << offset << " size=" << dataSize * m_dwBytesPerCluster << std::endl;
-                        }
-#endif
-                    }
-                
-                 
-                }
-                else
-	            {
-                    // Residence file data. (pr os this the stream size
-                    // Get actual 'data' size from this chunk of resident file data.
-		            LONGLONG realSize = pNtfsAttr->Attr.Resident.dwLength;
-                    //xx m_attrFilename.n64DiskSize = realSize;
+                    // One pass over the run list, disk layout of first stream and fragmentation 
+                    // of all streams. Sparse if a run has no clusters on disk.
+                    DataRun::Decode(*pNtfsAttr, m_dwBytesPerCluster, m_fileOnDisk.empty() ? &m_fileOnDisk : NULL, &m_frag);
+                    m_bSparse |= (m_frag.sparseRuns != 0);
                 }
             }
 			break;
@@ -385,17 +330,13 @@ int MFTRecord::ExtractFileOrMFT(
 		case 0x1000: //FIRST_USER_DEFINED_ATTRIBUTE
 			break;
 
-		case 0xFFFFFFFF: // END 
-			return ERROR_SUCCESS;
-
 		default:
 			break;
 		};
+	}
 
-		m_dwCurPos += pNtfsAttr->wFullLength; // go to the next location of attribute
-
-	} while (pNtfsAttr->wFullLength != 0);
-
+    if (attrIter.AtEnd())
+        m_typeCnt[0xf]++;    // END marker
 	return ERROR_SUCCESS;
 }
 
@@ -495,7 +436,7 @@ int MFTRecord::ExtractItems(const Block& inMFTBlock, ItemList& itemList, size_t
             {
                 // Save current buffer size, append data, push offset and size as a Block.
                 size_t offset = m_outFileData.size();
-                int nRet = ExtractData(*pNtfsAttr, m_outFileData, maxSize, NULL);
+                int nRet = ExtractData(*pNtfsAttr, m_outFileData, maxSize);
                 if (nRet)
 		            return nRet;
 
@@ -535,8 +476,7 @@ int MFTRecord::ExtractItems(const Block& inMFTBlock, ItemList& itemList, size_t
 int MFTRecord::ExtractData(
         const NTFS_ATTRIBUTE& ntfsAttr, 
         Buffer& outBuffer,              
-        size_t maxSize,
-        const FsFilter* pMFTFilter)     // Only set when reading MFT table.
+        size_t maxSize)
 {
 	DWORD dwCurPos = m_dwCurPos;
 
@@ -553,187 +493,65 @@ int MFTRecord::ExtractData(
 	else
 	{
         // Non-residence attribute, this resides in the other part of the physical drive
-
-        LONGLONG dwDataLen = ntfsAttr.Attr.NonResident.n64AllocSize;
-		if (!ntfsAttr.Attr.NonResident.n64AllocSize) // i don't know Y, but fails when its zero
-			dwDataLen = (ntfsAttr.Attr.NonResident.n64EndVCN - ntfsAttr.Attr.NonResident.n64StartVCN) + 1;
-
-		LONGLONG n64Len;    // Data length
-        LONGLONG n64Offset; // Data offset
-		LONGLONG n64LCN =0; // File offset to data on disk (LCN logical clustter number on physical drive)
-        
+        // Store file's disk layout for later use, ex: when loading directory names.
         m_fileOnDisk.clear();
+        if (!DataRun::Decode(ntfsAttr, m_dwBytesPerCluster, &m_fileOnDisk, NULL))
+            return ReturnError(ERROR_INVALID_DATA);
 
-		dwCurPos += ntfsAttr.Attr.NonResident.wDatarunOffset;
+        ReadPlan::ExtentList extents;
+        LONGLONG n64Total = 0;  // Bytes in extents, not yet read.
 
-        //  Iterator over non-resident data.
-        // ( [LengthOfSizes] [DataSize] [Offset] ) ... repeat until LengthOfSizes is zero.
-        //  Where LenghOfSizes is a byte with low nibble the size of the DataSize and
-        //  the upper nibble the size of the Offset value.
-        //  Ex:     0x04     = 4byte DataSize and 0byte Offset 
-        //          0x44     = 4byte DataSize and 4byte Offset
-		for (;;)
+        for (unsigned runIdx = 0; runIdx < m_fileOnDisk.size(); runIdx++)
 		{
-			// ---- Read the length of LCN/VCN and length  
-			BYTE lenOffSz = 0;
-            m_MFTBlock.Copy(&lenOffSz, dwCurPos, sizeof(BYTE));
-			dwCurPos += sizeof(BYTE);
-
-			if (!lenOffSz)
-				break;
-
-            // Split into Length Size and Offset Size
-			BYTE lenSize     = lenOffSz & 0x0F;
-			BYTE offSize	 = (lenOffSz & 0xF0) >> 4;
-
-			// ---- Read the data length  
-			n64Len = 0;
-            m_MFTBlock.Copy(&n64Len, dwCurPos, lenSize);
-			dwCurPos += lenSize;
-
-			// ---- Read the LCN/VCN offset 
-			n64Offset = 0;
-			m_MFTBlock.Copy(&n64Offset, dwCurPos, offSize);
-			dwCurPos += offSize;
-
-			//  If the last bit of n64Offset is 1 then fill remainder with bits on.
-			if ((((char*)&n64Offset)[offSize-1])&0x80)
-				for (int i=sizeof(LONGLONG)-1; i > (offSize-1); i--)
-					((char*)&n64Offset)[i] = (char)0xff;
-			
-			n64LCN += n64Offset;
-			n64Len *= m_dwBytesPerCluster;
-
-            // Store file's disk layout for later use, ex: when loading directory names.
-            m_fileOnDisk.push_back(std::pair<LONGLONG,LONGLONG>(n64LCN, n64Len));
-
-            if (outBuffer.size() > maxSize)
+            LONGLONG n64LCN = m_fileOnDisk[runIdx].first;  // Cluster of data on disk.
+            LONGLONG n64Len = m_fileOnDisk[runIdx].second;
+
+            if (outBuffer.size() + n64Total > maxSize)
                 return ReturnError(ERROR_NOT_ENOUGH_MEMORY);
 
-			// Data is available out side the MFT table, physical drive should be accessed
-			int nRet = ReadRaw(n64LCN, outBuffer, (DWORD)n64Len, pMFTFilter);
-			if (nRet)
-				return nRet;
+            ReadPlan::Extent extent;
+            extent.pos = n64LCN * m_dwBytesPerCluster + m_n64StartPos;
+            extent.len = (DWORD)n64Len;
+            extents.push_back(extent);
+            n64Total += n64Len;
 		}
-	}
 
-	return ERROR_SUCCESS;
-}
-
-// ------------------------------------------------------------------------------------------------
-// Extract the attribute data from the MFT table and append to buffer.
-// Data can be Resident & non-resident
-int MFTRecord::ExtractDataPos(
-        const NTFS_ATTRIBUTE& ntfsAttr, 
-        Buffer& outBuffer,              
-        size_t maxSize,
-        const FsFilter* pMFTFilter)     // Only set when reading MFT table.
-{
-	DWORD dwCurPos = m_dwCurPos;
-
-	if (!ntfsAttr.uchNonResFlag)
-	{
-        m_fileOnDisk.clear();
-	}
-	else
-	{
-        // Non-residence attribute, this resides in the other part of the physical drive
-
-        LONGLONG dwDataLen = ntfsAttr.Attr.NonResident.n64AllocSize;
-		if (!ntfsAttr.Attr.NonResident.n64AllocSize) // i don't know Y, but fails when its zero
-			dwDataLen = (ntfsAttr.Attr.NonResident.n64EndVCN - ntfsAttr.Attr.NonResident.n64StartVCN) + 1;
-
-		LONGLONG n64Len;    // Data length
-        LONGLONG n64Offset; // Data offset
-		LONGLONG n64LCN =0; // File offset to data on disk (LCN logical clustter number on physical drive)
-        
-        m_fileOnDisk.clear();
-
-		dwCurPos += ntfsAttr.Attr.NonResident.wDatarunOffset;
-
-        //  Iterator over non-resident data.
-        // ( [LengthOfSizes] [DataSize] [Offset] ) ... repeat until LengthOfSizes is zero.
-        //  Where LenghOfSizes is a byte with low nibble the size of the DataSize and
-        //  the upper nibble the size of the Offset value.
-        //  Ex:     0x04     = 4byte DataSize and 0byte Offset 
-        //          0x44     = 4byte DataSize and 4byte Offset
-		for (;;)
-		{
-			// ---- Read the length of LCN/VCN and length  
-			BYTE lenOffSz = 0;
-            m_MFTBlock.Copy(&lenOffSz, dwCurPos, sizeof(BYTE));
-			dwCurPos += sizeof(BYTE);
-
-			if (!lenOffSz)
-				break;
-
-            // Split into Length Size and Offset Size
-			BYTE lenSize     = lenOffSz & 0x0F;
-			BYTE offSize	 = (lenOffSz & 0xF0) >> 4;
-
-			// ---- Read the data length  
-			n64Len = 0;
-            m_MFTBlock.Copy(&n64Len, dwCurPos, lenSize);
-			dwCurPos += lenSize;
-
-			// ---- Read the LCN/VCN offset 
-			n64Offset = 0;
-			m_MFTBlock.Copy(&n64Offset, dwCurPos, offSize);
-			dwCurPos += offSize;
-
-			//  If the last bit of n64Offset is 1 then fill remainder with bits on.
-			if ((((char*)&n64Offset)[offSize-1])&0x80)
-				for (int i=sizeof(LONGLONG)-1; i > (offSize-1); i--)
-					((char*)&n64Offset)[i] = (char)0xff;
-			
-			n64LCN += n64Offset;
-			n64Len *= m_dwBytesPerCluster;
-
-            // Store file's disk layout for later use, ex: when loading directory names.
-            m_fileOnDisk.push_back(std::pair<LONGLONG,LONGLONG>(n64LCN, n64Len));
-
-            if (outBuffer.size() > maxSize)
-                return ReturnError(ERROR_NOT_ENOUGH_MEMORY);
-		}
+        // Read all runs at once, merged and in disk order.
+        if (!extents.empty())
+        {
+            DWORD error = ReadPlan::ReadAll(*m_pReader, extents, outBuffer, 
+                MFTconst::sMaxReadRequest, MFTconst::sMaxReadGap, MFTconst::sReadQueueDepth);
+            if (error != ERROR_SUCCESS)
+                return ReturnError(error);
+        }
 	}
 
 	return ERROR_SUCCESS;
 }
+
 // ------------------------------------------------------------------------------------------------
 // Read the data from the physical drive.
-int MFTRecord::ReadRaw(LONGLONG n64LCN, Buffer& buffer, DWORD dwLen, const FsFilter* pMFTFilter)
+int MFTRecord::ReadRaw(LONGLONG n64LCN, Buffer& buffer, DWORD dwLen)
 {
-    DWORD chunkSize = m_dwBytesPerCluster * 16;  
-	LARGE_INTEGER n64Pos;
-	n64Pos.QuadPart = (n64LCN)*m_dwBytesPerCluster;
-	n64Pos.QuadPart += m_n64StartPos;
-
-	// Data is available in the relative sector from the begining of the drive	
-	// so point that data.
-	int nRet = SetFilePointer(m_hDrive, n64Pos.LowPart, &n64Pos.HighPart, FILE_BEGIN);
-	if (nRet == -1)
-		return GetLastError();
+	LONGLONG n64Pos = n64LCN * m_dwBytesPerCluster + m_n64StartPos;
 
 	DWORD dwBytesRead  = 0;
 	DWORD dwBytes	   = 0;
 	DWORD dwTotRead	   = 0;
-	DWORD dwTotSaved   = 0;
-    bool haveFilter = (pMFTFilter != NULL) && pMFTFilter->IsValid();
     
 	while (dwTotRead < dwLen)
 	{
-		// dwBytesRead = m_dwBytesPerCluster;
-        dwBytesRead = haveFilter ? min(chunkSize, dwLen) : dwLen;  
+        dwBytesRead = dwLen - dwTotRead;  
         size_t begSize = buffer.size();
         buffer.resize(begSize + dwBytesRead);
 	    BYTE *pTmp = &buffer[begSize];
 
 		// Read chunk of data.
-		nRet = ReadFile(m_hDrive, pTmp, dwBytesRead, &dwBytes, NULL);
-		if (!nRet)
+		DWORD error = m_pReader->Read(n64Pos + dwTotRead, pTmp, dwBytesRead, dwBytes);
+		if (error != ERROR_SUCCESS || dwBytes == 0)
         {
             buffer.resize(begSize);
-			return GetLastError();
+			return (error != ERROR_SUCCESS) ? error : ReturnError(ERROR_HANDLE_EOF);
         }
 
 #if 0
@@ -755,49 +573,391 @@ int MFTRecord::ReadRaw(LONGLONG n64LCN, Buffer& buffer, DWORD dwLen, const FsFil
 #endif
 
 		dwTotRead += dwBytes;
+        buffer.resize(begSize + dwBytes);
+	}
+
+	return ERROR_SUCCESS;
+}
 
-        // Optionally filter MFT payload.
-        if (haveFilter && dwBytes != 0)
+// ------------------------------------------------------------------------------------------------
+// Compact MFT records in place, keeping records which pass filter. 
+// Chunk is assumed to be in units of MFT records.
+// Return number of bytes kept.
+DWORD MFTRecord::FilterRecords(BYTE* pData, DWORD dwLen, DWORD firstIndex, const FsFilter& filter, 
+    DirTable::EntryList* pDirs, MFTEntryList* pEntries, const FilterList* pTargets)
+{
+    DWORD mftCnt = dwLen / m_dwMFTRecSize;
+    assert(mftCnt * m_dwMFTRecSize == dwLen);
+
+    // Only parse the records this pass can use, directories are needed for paths and 
+    // in use records may be extensions of kept records.
+    BYTE want = m_select;
+    if (pDirs != NULL)
+        want |= RecordClass::sInUseDir;
+    if (m_deferAttrList && pEntries != NULL)
+        want |= RecordClass::sInUse | RecordClass::sInUseDir;
+    RecordClass::Select(pData, mftCnt, m_dwMFTRecSize, want, m_selection);
+
+    BYTE* pOutTmp = pData;
+    DWORD dwKept = 0;
+
+    // Selection is ascending, so kept records are never overwritten before they are read.
+    for (size_t selIdx = 0; selIdx < m_selection.size(); selIdx++)
+    {
+        BYTE* pInTmp = pData + (size_t)m_selection[selIdx] * m_dwMFTRecSize;
+        DWORD mftIndex = firstIndex + m_selection[selIdx];
+        Block mftBlock(pInTmp, m_dwMFTRecSize);
+        if (0 == ExtractFile(mftBlock, false, 0))
         {
-            // Read chunk is assumed to be in units of MFT records.
-            DWORD mftCnt = dwBytes / m_dwMFTRecSize;
-            assert(mftCnt * m_dwMFTRecSize == dwBytes);
+            const MFT_FILE_HEADER* pNtfsMFT = (const MFT_FILE_HEADER*)pInTmp;
+            bool defer = m_deferAttrList && pEntries != NULL && m_hasAttrList;
+            if (pNtfsMFT->n64BaseMftRec != 0)
+            {
+                // Extension record, not a file.
+                if (m_deferAttrList && pEntries != NULL && m_bInUse)
+                    AppendExtension(*pEntries);
+            }
+            else if (pDirs != NULL && (pNtfsMFT->wFlags & 0x02) != 0 
+                && m_attrFilename.chFileNameLength != 0)
+            {
+                // Free directories are only parsed when the scan selects free records (-X),
+                // deleted files need them for their path.
+                DirTable::DirEntry dirEntry;
+                dirEntry.mftIndex = mftIndex;
+                dirEntry.parent = (DWORD)(m_attrFilename.dwMftParentDir & sParentMask);
+                dirEntry.name.assign(m_attrFilename.wFilename, m_attrFilename.chFileNameLength);
+                pDirs->push_back(dirEntry);
+            }
 
-            MFTRecord mftRecord;
-            mftRecord.SetRecordInfo(0LL, m_dwMFTRecSize, m_dwBytesPerCluster);
+            // Records parsed only for their directory or extensions are not kept.
+            if (pNtfsMFT->n64BaseMftRec != 0 || (RecordClass::ClassOf(pInTmp) & m_select) == 0)
+                continue;
 
-            BYTE* pInTmp = pTmp;
-            BYTE* pOutTmp = pTmp;
-            dwBytes = 0;
+            bool keep;
+            if (pEntries != NULL)
+            {
+                AppendEntry(*pEntries, mftIndex, defer);
+                keep = defer || pEntries->FilterRow(pEntries->entries.size() - 1, filter, pTargets);
+                if (!keep)
+                    pEntries->PopRow();
+            }
+            else
+            {
+                keep = !filter.IsValid() || filter.IsMatch(m_attrStandard, m_attrFilename, MatchInfo(this));
+            }
 
-            while (mftCnt-- != 0)
+            if (keep)
             {
-                Block mftBlock(pInTmp, m_dwMFTRecSize);
-                if (0 == mftRecord.ExtractFile(mftBlock, false, 0))
-                {
-                    if (pMFTFilter->IsMatch(mftRecord.m_attrStandard, mftRecord.m_attrFilename, MatchInfo(& mftRecord)))
-                    {
-                        if (pInTmp != pOutTmp)
-                            memcpy(pOutTmp, pInTmp, m_dwMFTRecSize);
-                        dwBytes += m_dwMFTRecSize;
-                        pOutTmp += m_dwMFTRecSize;
-                    }
-                    pInTmp += m_dwMFTRecSize;
-                }
+                if (pInTmp != pOutTmp)
+                    memcpy(pOutTmp, pInTmp, m_dwMFTRecSize);
+                dwKept += m_dwMFTRecSize;
+                pOutTmp += m_dwMFTRecSize;
             }
+        }
+    }
+
+    return dwKept;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Append report fields of the record just extracted, see MFTEntryList::FilterRow.
+void MFTRecord::AppendEntry(MFTEntryList& entryList, DWORD mftIndex, bool attrList) const
+{
+    MFTEntry entry;
+    entry.n64Create     = m_attrStandard.n64Create;
+    entry.n64Modify     = m_attrStandard.n64Modify;
+    entry.n64Modfil     = m_attrStandard.n64Modfil;
+    entry.n64Access     = m_attrStandard.n64Access;
+    entry.diskSize      = m_attrFilename.n64DiskSize & sMaxFileSize;
+    entry.fileSize      = m_attrFilename.n64FileSize & sMaxFileSize;
+    entry.dwAttributes  = m_attrFilename.dwFlags;
+    entry.parentRef     = m_attrFilename.dwMftParentDir;
+    entry.nameOffset    = (DWORD)entryList.names.size();
+    entry.nameLen       = m_attrFilename.chFileNameLength;
+    entry.nameType      = m_attrFilename.chFileNameType;
+    entry.inUse         = m_bInUse;
+    entry.mftIndex      = mftIndex;
+    entry.seq           = m_MFTBlock.OutPtr<MFT_FILE_HEADER>(0)->wSequence;
+    entry.sparse        = m_bSparse;
+    entry.attrList      = attrList;
+    entry.hasSize       = m_hasSize;
+    entry.nameCnt       = (WORD)min(m_nameCnt, 0xffffu);
+    entry.streamCnt     = (WORD)min(m_streamCnt, 0xffffu);
+    entry.hardLinks     = m_hardLinks;
+    entry.frag          = m_frag;
+    entry.targetMask    = 0;
+
+    entryList.entries.push_back(entry);
+    entryList.names.insert(entryList.names.end(), m_attrFilename.wFilename, m_attrFilename.wFilename + entry.nameLen);
+}
+
+// ------------------------------------------------------------------------------------------------
+void MFTEntryList::Append(const MFTEntryList& other)
+{
+    DWORD nameBase = (DWORD)names.size();
+    entries.Append(other.entries, nameBase);
+    names.insert(names.end(), other.names.begin(), other.names.end());
+
+    size_t firstNew = extensions.size();
+    extensions.insert(extensions.end(), other.extensions.begin(), other.extensions.end());
+    for (size_t extIdx = firstNew; extIdx < extensions.size(); extIdx++)
+        extensions[extIdx].nameOffset += nameBase;
+}
+
+// ------------------------------------------------------------------------------------------------
+static bool LessBase(const MFTExtension& ext1, const MFTExtension& ext2)
+{
+    return ext1.baseIndex < ext2.baseIndex;
+}
+
+// ------------------------------------------------------------------------------------------------
+void MFTEntryList::SortExtensions()
+{
+    std::stable_sort(extensions.begin(), extensions.end(), LessBase);
+}
+
+// ------------------------------------------------------------------------------------------------
+std::pair<const MFTExtension*, const MFTExtension*> MFTEntryList::FindExtensions(DWORD baseIndex) const
+{
+    if (extensions.empty())
+        return std::make_pair((const MFTExtension*)NULL, (const MFTExtension*)NULL);
+
+    MFTExtension key;
+    key.baseIndex = baseIndex;
+    const MFTExtension* pBegin = extensions.data();
+    const MFTExtension* pEnd = pBegin + extensions.size();
+    return std::equal_range(pBegin, pEnd, key, LessBase);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Long names have a Win32 name and a DOS 8.3 alias, a Win32 name which is also a valid
+// 8.3 name is stored once as eBoth.
+unsigned MFTRecord::NameRank(BYTE nameType)
+{
+    switch (nameType & 3)
+    {
+    case eUnicode:
+    case eBoth:
+        return 2;
+    case ePOSIX:
+        return 1;
+    default:
+        return 0;
+    }
+}
 
-            for (unsigned mftRecIdx = 1; mftRecIdx < 16; mftRecIdx++)
-                m_typeCnt[mftRecIdx] += mftRecord.GetTypeCnts()[mftRecIdx];
+// ------------------------------------------------------------------------------------------------
+// Append attributes of the extension record just extracted, see MergeExtensions.
+void MFTRecord::AppendExtension(MFTEntryList& entryList) const
+{
+    MFTExtension ext;
+    ext.baseIndex   = (DWORD)(m_MFTBlock.OutPtr<MFT_FILE_HEADER>(0)->n64BaseMftRec & sParentMask);
+    ext.diskSize    = m_attrFilename.n64DiskSize;
+    ext.fileSize    = m_attrFilename.n64FileSize;
+    ext.parentRef   = m_attrFilename.dwMftParentDir;
+    ext.nameFlags   = m_attrFilename.dwFlags;
+    ext.nameOffset  = (DWORD)entryList.names.size();
+    ext.nameLen     = m_attrFilename.chFileNameLength;
+    ext.nameType    = m_attrFilename.chFileNameType;
+    ext.hasSize     = m_hasSize;
+    ext.sparse      = m_bSparse;
+    ext.nameCnt     = (WORD)min(m_nameCnt, 0xffffu);
+    ext.streamCnt   = (WORD)min(m_streamCnt, 0xffffu);
+    ext.frag        = m_frag;
+
+    entryList.extensions.push_back(ext);
+    entryList.names.insert(entryList.names.end(), m_attrFilename.wFilename, m_attrFilename.wFilename + ext.nameLen);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Base record keeps its own name and sizes, extensions add their names and streams.
+void MFTRecord::MergeExtensions(const MFTEntryList& entryList, DWORD baseIndex)
+{
+    std::pair<const MFTExtension*, const MFTExtension*> range = entryList.FindExtensions(baseIndex);
+    for (const MFTExtension* pExt = range.first; pExt != range.second; pExt++)
+    {
+        m_nameCnt   += pExt->nameCnt;
+        m_streamCnt += pExt->streamCnt;
+        m_bSparse   |= pExt->sparse;
+        m_frag.Add(pExt->frag);
+
+        if (!m_hasSize && pExt->hasSize)
+        {
+            m_attrFilename.n64DiskSize = pExt->diskSize;
+            m_attrFilename.n64FileSize = pExt->fileSize;
+            m_hasSize = true;
         }
 
-        buffer.resize(begSize + dwBytes);
-        dwTotSaved += dwBytes;
-	}
+        if (pExt->nameLen != 0 && (m_attrFilename.chFileNameLength == 0 
+            || NameRank(pExt->nameType) > NameRank(m_attrFilename.chFileNameType)))
+        {
+            m_attrFilename.dwMftParentDir = pExt->parentRef;
+            m_attrFilename.dwFlags = pExt->nameFlags;
+            m_attrFilename.chFileNameType = pExt->nameType;
+            m_attrFilename.chFileNameLength = pExt->nameLen;
+            memcpy(m_attrFilename.wFilename, entryList.names.data() + pExt->nameOffset, pExt->nameLen * sizeof(wchar_t));
+            m_attrFilename.wFilename[pExt->nameLen] = 0;
+        }
+    }
+}
 
-	dwLen = dwTotSaved;
+// ------------------------------------------------------------------------------------------------
+bool MFTEntryList::FilterRow(size_t row, const FsFilter& filter, const FilterList* pTargets)
+{
+    entries.m_targetMask[row] = 0;
+    if (!filter.IsValid() && (pTargets == NULL || pTargets->empty()))
+        return true;
+
+    // Attributes the filters test, taken from the columns. Name is terminated for the filters.
+    MFT_STANDARD attrStandard;
+    ZeroMemory(&attrStandard, sizeof(attrStandard));
+    attrStandard.n64Create = entries.m_create[row];
+    attrStandard.n64Modify = entries.m_modify[row];
+    attrStandard.n64Modfil = entries.m_modfil[row];
+    attrStandard.n64Access = entries.m_access[row];
+
+    MFT_FILEINFO attrFilename;
+    ZeroMemory(&attrFilename, sFileNameOffset);
+    attrFilename.dwMftParentDir   = entries.m_parentRef[row];
+    attrFilename.n64FileSize      = entries.m_fileSize[row];
+    attrFilename.n64DiskSize      = entries.m_diskSize[row];
+    attrFilename.dwFlags          = entries.m_attributes[row];
+    attrFilename.chFileNameLength = entries.m_nameLen[row];
+    attrFilename.chFileNameType   = entries.m_nameType[row];
+    if (attrFilename.chFileNameLength != 0)
+        memcpy(attrFilename.wFilename, names.data() + entries.m_nameOffset[row], attrFilename.chFileNameLength * sizeof(wchar_t));
+    attrFilename.wFilename[attrFilename.chFileNameLength] = 0;
+
+    MatchInfo matchInfo = MatchInfo::CatalogRow(&entries, row);
+    if (filter.IsValid() && !filter.IsMatch(attrStandard, attrFilename, matchInfo))
+        return false;
+
+    for (unsigned targetIdx = 0; pTargets != NULL && targetIdx < pTargets->size(); targetIdx++)
+    {
+        const FsFilter& nameFilter = *(*pTargets)[targetIdx];
+        if (!nameFilter.IsValid() || nameFilter.IsMatch(attrStandard, attrFilename, matchInfo))
+            entries.m_targetMask[row] |= 1ULL << targetIdx;
+    }
+    return true;
+}
 
-	return ERROR_SUCCESS;
+// ------------------------------------------------------------------------------------------------
+void MFTEntryList::PopRow()
+{
+    names.resize(entries.m_nameOffset.back());
+    entries.pop_back();
+}
+
+// ------------------------------------------------------------------------------------------------
+// Same as MFTRecord::MergeExtensions on the columns of row. Names of extensions are already
+// in the pool, a preferred one is used in place.
+void MFTEntryList::MergeExtensions(size_t row)
+{
+    std::pair<const MFTExtension*, const MFTExtension*> range = FindExtensions(entries.m_mftIndex[row]);
+    for (const MFTExtension* pExt = range.first; pExt != range.second; pExt++)
+    {
+        entries.m_nameCnt[row]   = (WORD)min(entries.m_nameCnt[row] + (unsigned)pExt->nameCnt, 0xffffu);
+        entries.m_streamCnt[row] = (WORD)min(entries.m_streamCnt[row] + (unsigned)pExt->streamCnt, 0xffffu);
+        if (pExt->sparse)
+            entries.m_state[row] |= FileCatalog::sSparse;
+        entries.m_frag[row].Add(pExt->frag);
+
+        if ((entries.m_state[row] & FileCatalog::sHasSize) == 0 && pExt->hasSize)
+        {
+            entries.m_diskSize[row] = pExt->diskSize & sMaxFileSize;
+            entries.m_fileSize[row] = pExt->fileSize & sMaxFileSize;
+            entries.m_state[row] |= FileCatalog::sHasSize;
+        }
+
+        if (pExt->nameLen != 0 && (entries.m_nameLen[row] == 0 
+            || MFTRecord::NameRank(pExt->nameType) > MFTRecord::NameRank(entries.m_nameType[row])))
+        {
+            entries.m_parentRef[row]  = pExt->parentRef;
+            entries.m_attributes[row] = pExt->nameFlags;
+            entries.m_nameType[row]   = pExt->nameType;
+            entries.m_nameLen[row]    = pExt->nameLen;
+            entries.m_nameOffset[row] = pExt->nameOffset;
+        }
+    }
 }
 
+// ------------------------------------------------------------------------------------------------
+// Extension records are merged from the catalog, records are not needed again.
+void MFTEntryList::FilterAttrLists(const FsFilter& filter, size_t firstRow, const FilterList* pTargets)
+{
+    SortExtensions();
+
+    size_t outRow = firstRow;
+    for (size_t row = firstRow; row < entries.size(); row++)
+    {
+        if ((entries.m_state[row] & FileCatalog::sAttrList) != 0)
+        {
+            MergeExtensions(row);
+            if (!FilterRow(row, filter, pTargets))
+                continue;
+        }
 
+        if (row != outRow)
+            entries.Set(outRow, entries.Get(row));
+        outRow++;
+    }
+    entries.resize(outRow);
+}
 
+// ------------------------------------------------------------------------------------------------
+// Catalog of a snapshot holds every file, the scan filter is applied without the records.
+void MFTEntryList::FilterRows(const FsFilter& filter, bool inUse, bool free, const FilterList* pTargets)
+{
+    size_t outRow = 0;
+    for (size_t row = 0; row < entries.size(); row++)
+    {
+        bool rowInUse = (entries.m_state[row] & FileCatalog::sInUse) != 0;
+        if (!(rowInUse ? inUse : free) || !FilterRow(row, filter, pTargets))
+            continue;
+
+        if (row != outRow)
+            entries.Set(outRow, entries.Get(row));
+        outRow++;
+    }
+    entries.resize(outRow);
+}
+
+// ------------------------------------------------------------------------------------------------
+int MFTRecord::GetAttrList(AttrList& attrList)
+{
+    attrList.clear();
+    if (!m_hasAttrList)
+        return ERROR_SUCCESS;
+
+    const NTFS_ATTRIBUTE* pNtfsAttr = m_MFTBlock.OutPtr<NTFS_ATTRIBUTE>(m_attrListPos);
+    if (pNtfsAttr->uchNonResFlag && m_pReader == NULL)
+        return ReturnError(ERROR_INVALID_FUNCTION);
+
+    // ExtractData replaces file layout with the list's data runs.
+    Buffer listData;
+    FileOnDiskList fileOnDisk(m_fileOnDisk);
+    m_dwCurPos = m_attrListPos;
+    int nRet = ExtractData(*pNtfsAttr, listData, MFTconst::sMaxSizeAny);
+    m_fileOnDisk.swap(fileOnDisk);
+    if (nRet)
+        return nRet;
+    if (pNtfsAttr->uchNonResFlag && (ULONGLONG)listData.size() > (ULONGLONG)pNtfsAttr->Attr.NonResident.n64RealSize)
+        listData.resize((size_t)pNtfsAttr->Attr.NonResident.n64RealSize);
+
+    size_t off = 0;
+    while (off + sizeof(NTFS_ATTRLIST_ENTRY) <= listData.size())
+    {
+        const NTFS_ATTRLIST_ENTRY* pListEntry = (const NTFS_ATTRLIST_ENTRY*)(listData.Data() + off);
+        if (pListEntry->wRecLength < sizeof(NTFS_ATTRLIST_ENTRY))
+            break;
+
+        AttrListEntry entry;
+        entry.type      = pListEntry->dwType;
+        entry.startVCN  = pListEntry->n64StartVCN;
+        entry.mftIndex  = (DWORD)(pListEntry->n64MftRef & sParentMask);
+        entry.nameLen   = pListEntry->uchNameLength;
+        attrList.push_back(entry);
+        off += pListEntry->wRecLength;
+    }
+    return ERROR_SUCCESS;
+}
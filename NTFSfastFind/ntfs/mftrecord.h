@@ -36,8 +36,13 @@
 #pragma once
 
 #include "BaseTypes.h"
+#include "DataRun.h"
+#include "DirTable.h"
+#include "FileCatalog.h"
 #include "FsFilter.h"
 #include "NtfsTypes.h"
+#include "RecordClass.h"
+#include "VolumeReader.h"
 
 #include <map>
 #include <string>
@@ -62,6 +67,151 @@ const unsigned sEA_DATA              = 0xe0;  //  ??
 const unsigned sEND                  = 0xf0;  //  ??
 
 const unsigned sMaxSizeAny = (unsigned)-1;
+const unsigned sMaxReadRequest = 4 << 20;   // Largest merged read of attribute data runs.
+const unsigned sMaxReadGap = 256 << 10;     // Largest hole read over between data runs.
+const unsigned sReadQueueDepth = 4;         // Data run reads in flight.
+};
+
+// ------------------------------------------------------------------------------------------------
+// Walk the attributes of one MFT record in place, nothing is copied. Each attribute header
+// must lie inside the record, walk stops at the end marker or at the first bad header.
+//
+//  Ex:
+//      for (AttrIter attrIter(mftBlock, pNtfsMFT->wAttribOffset); attrIter.IsValid(); attrIter.Next())
+//          if (attrIter->dwType == MFTconst::sSTANDARD_INFORMATION)
+//              const BYTE* pValue = attrIter.Value(sizeof(MFT_STANDARD));
+
+class AttrIter
+{
+public:
+    AttrIter(const Block& record, DWORD offset) :
+        m_pRecord((const BYTE*)record.OutVPtr(0)), m_size((DWORD)record.size()), 
+        m_offset(offset), m_pAttr(NULL), m_atEnd(false)
+    { Check(); }
+
+    bool IsValid() const
+    { return m_pAttr != NULL; }
+
+    // True if walk stopped at the end marker rather than a bad header.
+    bool AtEnd() const
+    { return m_atEnd; }
+
+    void Next()
+    {
+        m_offset += m_pAttr->wFullLength;
+        Check();
+    }
+
+    const NTFS_ATTRIBUTE& operator*() const
+    { return *m_pAttr; }
+    const NTFS_ATTRIBUTE* operator->() const
+    { return m_pAttr; }
+
+    // Offset of attribute header in record.
+    DWORD Offset() const
+    { return m_offset; }
+
+    // Resident value if it lies inside the attribute and holds at least minLen bytes, else NULL.
+    const BYTE* Value(DWORD minLen = 0) const
+    {
+        if (m_pAttr->uchNonResFlag != 0 || m_pAttr->wFullLength < sResidentHdrSize)
+            return NULL;
+        DWORD valueOff = m_pAttr->Attr.Resident.wAttrOffset;
+        DWORD valueLen = m_pAttr->Attr.Resident.dwLength;
+        if (valueLen < minLen || valueOff > m_pAttr->wFullLength || valueLen > m_pAttr->wFullLength - valueOff)
+            return NULL;
+        return (const BYTE*)m_pAttr + valueOff;
+    }
+
+    DWORD ValueLength() const
+    { return m_pAttr->Attr.Resident.dwLength; }
+
+private:
+    static const DWORD sMinHdrSize = 16;        // Common part of attribute header.
+    static const DWORD sResidentHdrSize = 24;
+
+    void Check()
+    {
+        m_pAttr = NULL;
+        if (m_offset > m_size || m_size - m_offset < sizeof(DWORD))
+            return;
+        const NTFS_ATTRIBUTE* pAttr = (const NTFS_ATTRIBUTE*)(m_pRecord + m_offset);
+        if (pAttr->dwType == 0xFFFFFFFF)
+            m_atEnd = true;
+        else if (m_size - m_offset >= sMinHdrSize && pAttr->wFullLength >= sMinHdrSize 
+            && pAttr->wFullLength <= m_size - m_offset)
+            m_pAttr = pAttr;
+    }
+
+    const BYTE*             m_pRecord;
+    DWORD                   m_size;
+    DWORD                   m_offset;
+    const NTFS_ATTRIBUTE*   m_pAttr;    // NULL at end of walk.
+    bool                    m_atEnd;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Attributes found in an extension record (n64BaseMftRec != 0), they are merged into the
+// base record rather than reported as a file, see MFTRecord::MergeExtensions.
+struct MFTExtension
+{
+    DWORD       baseIndex;      // MFT index of base record.
+    LONGLONG    diskSize;       // Sizes of first $DATA segment, if hasSize.
+    LONGLONG    fileSize;
+    LONGLONG    parentRef;      // Parent of preferred name, if nameLen != 0.
+    DWORD       nameFlags;
+    DWORD       nameOffset;     // Name in MFTEntryList::names, not terminated.
+    BYTE        nameLen;
+    BYTE        nameType;       // MFTFileInfoTypes
+    bool        hasSize;
+    bool        sparse;
+    WORD        nameCnt;
+    WORD        streamCnt;
+    FragInfo    frag;           // Of $DATA segments in extension record.
+};
+
+struct MFTEntryList
+{
+    typedef std::vector<const FsFilter*> FilterList;
+
+    FileCatalog                 entries;
+    std::vector<MFTExtension>   extensions;     // Sorted by baseIndex once loaded.
+    std::vector<wchar_t>        names;
+
+    void clear()
+    {
+        entries.clear();
+        extensions.clear();
+        names.clear();
+    }
+
+    // Append other list, its name offsets are rebased.
+    void Append(const MFTEntryList& other);
+
+    // Sort extensions by base record, required by FindExtensions.
+    void SortExtensions();
+
+    // Return range of extensions of base record.
+    std::pair<const MFTExtension*, const MFTExtension*> FindExtensions(DWORD baseIndex) const;
+
+    // Test row against filter and set its targetMask, a bit per pTargets filter matched.
+    // Filters see the attributes held in the catalog columns, not the record.
+    // Return true if row passes filter.
+    bool FilterRow(size_t row, const FsFilter& filter, const FilterList* pTargets);
+
+    // Remove last row, and its name which is last in the pool.
+    void PopRow();
+
+    // Merge extensions into the rows with an $ATTRIBUTE_LIST from firstRow on, then filter
+    // them (see FilterRow). Rows are compacted in place.
+    void FilterAttrLists(const FsFilter& filter, size_t firstRow, const FilterList* pTargets);
+
+    // Keep rows in the in use state wanted (inUse, free) which pass filter (see FilterRow),
+    // used on a catalog loaded unfiltered. Rows are compacted in place.
+    void FilterRows(const FsFilter& filter, bool inUse, bool free, const FilterList* pTargets);
+
+    // Merge extension attributes into row, extensions must be sorted.
+    void MergeExtensions(size_t row);
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -74,18 +224,15 @@ public:
 
 	int SetRecordInfo(LONGLONG n64StartPos, DWORD dwRecSize, DWORD dwBytesPerCluster);
 
-	void SetDriveHandle(HANDLE hDrive)
-    {  m_hDrive = hDrive; }
+	void SetReader(VolumeReader* pReader)
+    {  m_pReader = pReader; }
 
 	int ExtractFile(const Block& inMFTBlock, bool loadData=false, size_t maxDataSize=0xffffffff)
     { return ExtractFileOrMFT(inMFTBlock, loadData, maxDataSize); }
 
     // Call if you want to see the stream names and m_streamCnt != 0
     int ExtractStream(const Block& inMFTBlock, StreamFilter* pStreamFilter)
-    { return ExtractFileOrMFT(inMFTBlock, false, MFTconst::sMaxSizeAny, NULL, pStreamFilter); }
-
-    int ExtractMFT(const Block& inMFTBlock, const FsFilter& filter, size_t maxDataSize=0xffffffff)
-    { return ExtractFileOrMFT(inMFTBlock, true, maxDataSize, &filter); }
+    { return ExtractFileOrMFT(inMFTBlock, false, MFTconst::sMaxSizeAny, pStreamFilter); }
 
   
     struct MFTitem
@@ -98,7 +245,63 @@ public:
 
     int ExtractItems(const Block& inMFTBlock, ItemList& itemList, size_t maxDataSize=0xffffffff);
 
-	int ReadRaw(LONGLONG n64LCN, Buffer& chData, DWORD dwLen, const FsFilter* pMFTFilter=NULL);
+	int ReadRaw(LONGLONG n64LCN, Buffer& chData, DWORD dwLen);
+
+    typedef MFTEntryList::FilterList FilterList;
+
+    // Compact block of MFT records in place, keeping records which pass filter.
+    // Optionally collect all in use directories (free ones too if selected) before filtering,
+    // and the entry of each kept record with a targetMask bit per matching target filter.
+    // With pEntries the filters test the entry (see MFTEntryList::FilterRow), else the record.
+    // Extension records are never kept, with SetDeferAttrList their attributes are added to
+    // pEntries extensions and base records with an $ATTRIBUTE_LIST are kept unfiltered.
+    // firstIndex is the MFT index of the first record, indexes come from the record position
+    // rather than the header (dwMFTRecNumber is only set by NTFS 3.1, and is not trusted).
+    // Return number of bytes kept.
+    DWORD FilterRecords(BYTE* pData, DWORD dwLen, DWORD firstIndex, const FsFilter& filter, 
+        DirTable::EntryList* pDirs = NULL, MFTEntryList* pEntries = NULL, const FilterList* pTargets = NULL);
+
+    // Record classes FilterRecords parses, see RecordClass, others are dropped unparsed.
+    void SetSelect(BYTE want)
+    { m_select = want; }
+
+    // Defer filter of base records with an $ATTRIBUTE_LIST until their extension records are
+    // merged (see MFTEntryList::FilterAttrLists), requires pEntries in FilterRecords.
+    void SetDeferAttrList(bool defer)
+    { m_deferAttrList = defer; }
+
+    // Merge extension attributes into record just extracted, extensions must be sorted.
+    void MergeExtensions(const MFTEntryList& entryList, DWORD baseIndex);
+
+    // Append attributes of extension record just extracted to entryList extensions.
+    void AppendExtension(MFTEntryList& entryList) const;
+
+    // $ATTRIBUTE_LIST entry, where an attribute (or segment of one) is stored.
+    struct AttrListEntry
+    {
+        DWORD       type;
+        LONGLONG    startVCN;
+        DWORD       mftIndex;   // Record holding the attribute.
+        BYTE        nameLen;
+    };
+    typedef std::vector<AttrListEntry> AttrList;
+
+    // One $FILE_NAME attribute, name is in m_namePool.
+    struct NameRef
+    {
+        LONGLONG    parentRef;  // Seq[2] parent-dir[6] MFT entry
+        DWORD       nameOffset;
+        BYTE        nameLen;
+        BYTE        nameType;   // MFTFileInfoTypes
+    };
+    typedef std::vector<NameRef> NameList;
+
+    // Rank of name shown for record, Win32 over POSIX over DOS 8.3 alias.
+    static unsigned NameRank(BYTE nameType);
+
+    // Read $ATTRIBUTE_LIST of record just extracted, return 0 on success, else last error.
+    // Non resident lists are read with the reader.
+    int GetAttrList(AttrList& attrList);
     
 public:
     //  attributes  
@@ -112,29 +315,36 @@ public:
 	bool            m_bInUse;       // false = deleted
     bool            m_bSparse;
     unsigned        m_nameCnt;      // number of name attributes found.
+    NameList        m_names;        // All names (hard links, DOS alias), m_attrFilename is preferred one.
+    std::vector<wchar_t> m_namePool;  // Text of m_names, not terminated.
+    WORD            m_hardLinks;    // Hard link count of record header.
     unsigned        m_streamCnt;    // number of data streams found.
-    unsigned        m_fragCnt;      // number of allocation fragments. 
+    FragInfo        m_frag;         // Fragmentation of all $DATA streams.
+    bool            m_hasAttrList;  // $ATTRIBUTE_LIST found, attributes may be in extension records.
+    bool            m_hasSize;      // Sizes set from first segment of non resident $DATA.
 
     static char*    sMFTRecordTypeStr[];
 
 protected:
-	HANDLE	        m_hDrive;   // Does not own handle, shares it with parent.
+	VolumeReader*   m_pReader;  // Does not own reader, shares it with parent.
  	Block           m_MFTBlock;
 	DWORD           m_dwMFTRecSize;
 	DWORD           m_dwCurPos;
 	DWORD           m_dwBytesPerCluster;
 	LONGLONG        m_n64StartPos;
+    DWORD           m_attrListPos;  // Offset of $ATTRIBUTE_LIST attribute in m_MFTBlock.
+    bool            m_deferAttrList;
+    BYTE            m_select;       // RecordClass bits parsed by FilterRecords.
+    RecordClass::Selection m_selection;
 
     int ExtractFileOrMFT(const Block& inMFTBlock, 
             bool loadData=false, size_t maxFile=0xfffffff, 
-            const FsFilter* pMFTFilter=NULL,
             const StreamFilter* pStreamFilter=NULL);
 
     int ExtractData(const NTFS_ATTRIBUTE& ntfsAttr, 
-            Buffer& outBuffer, size_t maxSize, const FsFilter* pMFTFilter=NULL);
+            Buffer& outBuffer, size_t maxSize);
 
-    int ExtractDataPos(const NTFS_ATTRIBUTE& ntfsAttr, 
-            Buffer& outBuffer, size_t maxSize, const FsFilter* pMFTFilter=NULL);
+    void AppendEntry(MFTEntryList& entryList, DWORD mftIndex, bool attrList) const;
 
 public:
     typedef DWORD   TypeCnt[16];
@@ -0,0 +1,320 @@
+// ------------------------------------------------------------------------------------------------
+// MFT snapshot file, on disk copy of the file catalog reused by later scans of a volume.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "MFTSnapshot.h"
+#include "Hnd.h"
+
+static const char sSnapshotMagic[8] = { 'N', 'T', 'F', 'S', 'F', 'F', 'S', '3' };
+static const LONGLONG sTicksPerSecond = 10000000;   // FILETIME units.
+
+#pragma pack(push, 1)
+struct SnapshotHeader
+{
+    char                magic[8];
+    MFTSnapshot::Key    key;
+    LONGLONG            buildTime;  // FILETIME (UTC) snapshot was written.
+    DWORD               rows;       // Catalog rows.
+    DWORD               names;      // Characters in name pool.
+    DWORD               extensions;
+    DWORD               dirNodes;
+    DWORD               dirNames;
+};
+#pragma pack(pop)
+
+// ------------------------------------------------------------------------------------------------
+// Write columns one after the other, the first error stops the rest.
+class ColumnWriter
+{
+public:
+    ColumnWriter(HANDLE hnd, DWORD error) :
+        m_hnd(hnd), m_error(error)
+    { }
+
+    template <typename T>
+    void operator()(const std::vector<T>& column)
+    {
+        const BYTE* pData = (const BYTE*)column.data();
+        size_t len = column.size() * sizeof(T);
+        const DWORD sWriteSize = 4 << 20;
+        for (size_t off = 0; m_error == ERROR_SUCCESS && off < len; off += sWriteSize)
+        {
+            DWORD writeLen = (DWORD)min((size_t)sWriteSize, len - off);
+            DWORD dwBytes;
+            if (!WriteFile(m_hnd, pData + off, writeLen, &dwBytes, NULL))
+                m_error = GetLastError();
+        }
+    }
+
+    DWORD Error() const
+    { return m_error; }
+
+private:
+    HANDLE  m_hnd;
+    DWORD   m_error;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Read columns one after the other, a column is only allocated once it is known to lie in 
+// the file. The first error stops the rest.
+class ColumnReader
+{
+public:
+    ColumnReader(VolumeReader& reader, LONGLONG offset) :
+        m_reader(reader), m_offset(offset), m_error(ERROR_SUCCESS)
+    { }
+
+    template <typename T>
+    void operator()(std::vector<T>& column, size_t count)
+    {
+        if (m_error != ERROR_SUCCESS)
+            return;
+        if ((ULONGLONG)count * sizeof(T) > (ULONGLONG)(m_reader.Size() - m_offset))
+        {
+            m_error = ERROR_INVALID_DATA;
+            return;
+        }
+
+        column.resize(count);
+        BYTE* pData = (BYTE*)column.data();
+        size_t len = count * sizeof(T);
+        const DWORD sReadSize = 4 << 20;
+        for (size_t off = 0; m_error == ERROR_SUCCESS && off < len; off += sReadSize)
+        {
+            DWORD readLen = (DWORD)min((size_t)sReadSize, len - off);
+            DWORD dwBytes = 0;
+            m_error = m_reader.Read(m_offset + off, pData + off, readLen, dwBytes);
+            if (m_error == ERROR_SUCCESS && dwBytes != readLen)
+                m_error = ERROR_HANDLE_EOF;
+        }
+        m_offset += len;
+    }
+
+    LONGLONG Offset() const
+    { return m_offset; }
+
+    DWORD Error() const
+    { return m_error; }
+
+private:
+    VolumeReader&   m_reader;
+    LONGLONG        m_offset;
+    DWORD           m_error;
+};
+
+// ------------------------------------------------------------------------------------------------
+static LONGLONG SystemTime()
+{
+    FILETIME fileTime;
+    GetSystemTimeAsFileTime(&fileTime);
+    return ((LONGLONG)fileTime.dwHighDateTime << 32) | fileTime.dwLowDateTime;
+}
+
+// ------------------------------------------------------------------------------------------------
+std::wstring MFTSnapshot::MakePath(const std::wstring& directory, const Key& key)
+{
+    wchar_t name[64];
+    _snwprintf_s(name, ARRAYSIZE(name), L"NTFSfastFind-%016llx%s.snap", 
+        key.serialNumber, key.skipFree ? L"" : L"-all");
+
+    std::wstring path = directory;
+    if (!path.empty() && path[path.length() - 1] != '\\' && path[path.length() - 1] != '/')
+        path += L"\\";
+    return path + name;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Columns are in the order Write stores them.
+DWORD MFTSnapshot::Read(const wchar_t* path, const Key& key, DWORD maxAge, 
+    MFTEntryList& entryList, DirTable& dirTable, LONGLONG& bytes)
+{
+    entryList.clear();
+    dirTable.Clear();
+    bytes = 0;
+
+    ImageReader image;
+    DWORD error = image.Open(path);
+    if (error != ERROR_SUCCESS)
+        return error;
+
+    SnapshotHeader header;
+    DWORD dwBytes = 0;
+    error = image.Read(0, &header, sizeof(header), dwBytes);
+    if (error != ERROR_SUCCESS)
+        return error;
+
+    LONGLONG now = SystemTime();
+    if (dwBytes != sizeof(header)
+        || memcmp(header.magic, sSnapshotMagic, sizeof(sSnapshotMagic)) != 0
+        || !(header.key == key)
+        || header.buildTime > now
+        || (now - header.buildTime) / sTicksPerSecond >= (LONGLONG)maxAge)
+        return ERROR_INVALID_DATA;      // Other volume, stale or damaged.
+
+    FileCatalog& catalog = entryList.entries;
+    ColumnReader readColumn(image, sHeaderSize);
+    readColumn(catalog.m_mftIndex, header.rows);
+    readColumn(catalog.m_parentRef, header.rows);
+    readColumn(catalog.m_seq, header.rows);
+    readColumn(catalog.m_attributes, header.rows);
+    readColumn(catalog.m_state, header.rows);
+    readColumn(catalog.m_fileSize, header.rows);
+    readColumn(catalog.m_diskSize, header.rows);
+    readColumn(catalog.m_create, header.rows);
+    readColumn(catalog.m_modify, header.rows);
+    readColumn(catalog.m_modfil, header.rows);
+    readColumn(catalog.m_access, header.rows);
+    readColumn(catalog.m_nameCnt, header.rows);
+    readColumn(catalog.m_streamCnt, header.rows);
+    readColumn(catalog.m_hardLinks, header.rows);
+    readColumn(catalog.m_nameOffset, header.rows);
+    readColumn(catalog.m_nameLen, header.rows);
+    readColumn(catalog.m_nameType, header.rows);
+    readColumn(catalog.m_targetMask, header.rows);
+    readColumn(catalog.m_frag, header.rows);
+    readColumn(entryList.names, header.names);
+    readColumn(entryList.extensions, header.extensions);
+    readColumn(dirTable.m_nodes, header.dirNodes);
+    readColumn(dirTable.m_names, header.dirNames);
+
+    error = readColumn.Error();
+    if (error == ERROR_SUCCESS 
+        && (readColumn.Offset() != image.Size() || !IsConsistent(entryList, dirTable, key.recordCount)))
+        error = ERROR_INVALID_DATA;
+    if (error != ERROR_SUCCESS)
+    {
+        entryList.clear();
+        dirTable.Clear();
+        return error;
+    }
+
+    for (size_t mftIndex = 0; mftIndex < dirTable.m_nodes.size(); mftIndex++)
+    {
+        if (dirTable.m_nodes[mftIndex].parent != DirTable::sNoDir)
+            dirTable.m_count++;
+    }
+    bytes = readColumn.Offset();
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Snapshot file is input like the volume, reports use indexes and name offsets unchecked.
+bool MFTSnapshot::IsConsistent(const MFTEntryList& entryList, const DirTable& dirTable, DWORD recordCount)
+{
+    const FileCatalog& catalog = entryList.entries;
+    size_t nameCnt = entryList.names.size();
+    for (size_t row = 0; row < catalog.size(); row++)
+    {
+        if (catalog.m_mftIndex[row] >= recordCount
+            || catalog.m_nameOffset[row] > nameCnt || catalog.m_nameLen[row] > nameCnt - catalog.m_nameOffset[row])
+            return false;
+    }
+
+    for (size_t extIdx = 0; extIdx < entryList.extensions.size(); extIdx++)
+    {
+        const MFTExtension& ext = entryList.extensions[extIdx];
+        if (ext.baseIndex >= recordCount || ext.nameOffset > nameCnt || ext.nameLen > nameCnt - ext.nameOffset)
+            return false;
+    }
+
+    if (dirTable.m_nodes.size() > recordCount)
+        return false;
+    size_t dirNameCnt = dirTable.m_names.size();
+    for (size_t mftIndex = 0; mftIndex < dirTable.m_nodes.size(); mftIndex++)
+    {
+        const DirTable::Node& node = dirTable.m_nodes[mftIndex];
+        if (node.parent == DirTable::sNoDir)
+            continue;
+        if (node.nameOff >= dirNameCnt || dirTable.m_names[node.nameOff] > dirNameCnt - node.nameOff - 1)
+            return false;
+    }
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Write to temporary file then rename, so readers never see a partial snapshot.
+DWORD MFTSnapshot::Write(const wchar_t* path, const Key& key, const MFTEntryList& entryList, const DirTable& dirTable)
+{
+    std::wstring tmpPath = std::wstring(path) + L".tmp";
+    DWORD error = ERROR_SUCCESS;
+    {
+        Hnd hnd = CreateFile(tmpPath.c_str(), GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (!hnd.IsValid())
+            return GetLastError();
+
+        const FileCatalog& catalog = entryList.entries;
+        Buffer header;
+        header.resize(sHeaderSize);
+        SnapshotHeader* pHeader = (SnapshotHeader*)header.Data();
+        memcpy(pHeader->magic, sSnapshotMagic, sizeof(sSnapshotMagic));
+        pHeader->key        = key;
+        pHeader->buildTime  = SystemTime();
+        pHeader->rows       = (DWORD)catalog.size();
+        pHeader->names      = (DWORD)entryList.names.size();
+        pHeader->extensions = (DWORD)entryList.extensions.size();
+        pHeader->dirNodes   = (DWORD)dirTable.m_nodes.size();
+        pHeader->dirNames   = (DWORD)dirTable.m_names.size();
+
+        DWORD dwBytes;
+        if (!WriteFile(hnd, header.Data(), sHeaderSize, &dwBytes, NULL))
+            error = GetLastError();
+
+        ColumnWriter writeColumn(hnd, error);
+        writeColumn(catalog.m_mftIndex);
+        writeColumn(catalog.m_parentRef);
+        writeColumn(catalog.m_seq);
+        writeColumn(catalog.m_attributes);
+        writeColumn(catalog.m_state);
+        writeColumn(catalog.m_fileSize);
+        writeColumn(catalog.m_diskSize);
+        writeColumn(catalog.m_create);
+        writeColumn(catalog.m_modify);
+        writeColumn(catalog.m_modfil);
+        writeColumn(catalog.m_access);
+        writeColumn(catalog.m_nameCnt);
+        writeColumn(catalog.m_streamCnt);
+        writeColumn(catalog.m_hardLinks);
+        writeColumn(catalog.m_nameOffset);
+        writeColumn(catalog.m_nameLen);
+        writeColumn(catalog.m_nameType);
+        writeColumn(catalog.m_targetMask);
+        writeColumn(catalog.m_frag);
+        writeColumn(entryList.names);
+        writeColumn(entryList.extensions);
+        writeColumn(dirTable.m_nodes);
+        writeColumn(dirTable.m_names);
+        error = writeColumn.Error();
+    }
+
+    if (error == ERROR_SUCCESS && !MoveFileEx(tmpPath.c_str(), path, MOVEFILE_REPLACE_EXISTING))
+        error = GetLastError();
+    if (error != ERROR_SUCCESS)
+        DeleteFile(tmpPath.c_str());
+    return error;
+}
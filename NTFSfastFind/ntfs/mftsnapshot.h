@@ -0,0 +1,87 @@
+// ------------------------------------------------------------------------------------------------
+// MFT snapshot file, on disk copy of the file catalog reused by later scans of a volume.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+#include "DirTable.h"
+#include "MFTRecord.h"
+
+#include <string>
+
+// ------------------------------------------------------------------------------------------------
+// Snapshot of the file catalog (MFTEntryList columns, names and extensions) and directory 
+// table of a volume, built from every file (every in use file with skipFree). The catalog
+// is loaded as is, no record is parsed, the scan filter is applied to the loaded rows.
+// A snapshot is used while its key matches the volume and it is younger than a max age.
+//
+//  Ex:
+//      if (MFTSnapshot::Read(path, key, maxAge, entryList, dirTable, bytes) != ERROR_SUCCESS)
+//          MFTSnapshot::Write(path, key, entryList, dirTable);   // After loading the volume.
+
+class MFTSnapshot
+{
+public:
+    // Volume and layout of its MFT, not its content. Records change with every file
+    // written, a live volume would never match them.
+    struct Key
+    {
+        LONGLONG    serialNumber;   // NTFS_PART_BOOT_SEC bpb.serialNumber
+        LONGLONG    mftLsn;         // $MFT record n64LogSeqNumber, changes when the MFT grows.
+        DWORD       recordCount;    // Records in $MFT:$DATA.
+        DWORD       recordSize;
+        DWORD       skipFree;       // 1 if free records are not in snapshot.
+
+        bool operator==(const Key& other) const
+        {
+            return serialNumber == other.serialNumber && mftLsn == other.mftLsn 
+                && recordCount == other.recordCount && recordSize == other.recordSize 
+                && skipFree == other.skipFree;
+        }
+    };
+
+    // Return snapshot file name for volume in directory.
+    static std::wstring MakePath(const std::wstring& directory, const Key& key);
+
+    // Load catalog and directory table of snapshot, set bytes to its size.
+    // Return 0 if it exists, matches key and is at most maxAge seconds old, else error.
+    static DWORD Read(const wchar_t* path, const Key& key, DWORD maxAge, 
+        MFTEntryList& entryList, DirTable& dirTable, LONGLONG& bytes);
+
+    // Write catalog and directory table to path, replacing previous snapshot.
+    // Return 0 on success, else last error.
+    static DWORD Write(const wchar_t* path, const Key& key, const MFTEntryList& entryList, const DirTable& dirTable);
+
+private:
+    static const DWORD sHeaderSize = 4096;     // Columns start page aligned.
+
+    // Return true if every MFT index is below recordCount and every name lies in its pool.
+    static bool IsConsistent(const MFTEntryList& entryList, const DirTable& dirTable, DWORD recordCount);
+};
@@ -93,6 +93,19 @@ struct	NTFS_ATTRIBUTE
 	}Attr;
 } ;
 
+// ------------------------------------------------------------------------------------------------
+// $ATTRIBUTE_LIST entry, one per attribute (or segment of a split attribute) of the file.
+struct NTFS_ATTRLIST_ENTRY
+{
+	DWORD		dwType;
+	WORD		wRecLength;			// Length of entry, including name
+	BYTE		uchNameLength;
+	BYTE		uchNameOffset;
+	LONGLONG	n64StartVCN;		// First VCN of segment, 0 if resident
+	LONGLONG	n64MftRef;			// Seq[2] record[6] holding the attribute
+	WORD		wID;
+};
+
 // ------------------------------------------------------------------------------------------------
 //  Attributes 
 struct MFT_STANDARD 
@@ -38,7 +38,11 @@
 #include "MFTRecord.h"
 #include "LocaleFmt.h"
 #include "oNullStream.h"
+#include "ReadPlan.h"
+#include "RecordFixup.h"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -249,6 +253,9 @@ struct NTFS_PART_BOOT_SEC
 };
 #pragma pack(pop, curAlignment)
 
+// Files are reported in batches so their missing directories can be read together.
+static const unsigned sReportBatch = 1024;
+
 // ------------------------------------------------------------------------------------------------
 static DWORD ReturnError(DWORD error)
 {
@@ -264,8 +271,21 @@ NtfsUtil::NtfsUtil(void) :
 	m_startSector(0),
 	m_bytesPerCluster(0),
 	m_bytesPerSector(0),
-	m_dwMFTRecordSz(0)
+    m_sectorSize(RecordFixup::sMinStride),
+	m_dwMFTRecordSz(0),
+    m_mftRecords(0),
+    m_skipFree(false),
+    m_select(RecordClass::sAnyFile),
+    m_keepRecords(false),
+    m_streaming(false),
+    m_retainMFT(false),
+    m_refreshSnapshot(false),
+    m_snapshotMaxAge(0),
+    m_fromSnapshot(false),
+    m_volumeSerial(0),
+    m_pTargets(NULL)
 {
+    ZeroMemory(m_typeCnt, sizeof(m_typeCnt));
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -424,6 +444,9 @@ DWORD NtfsUtil::QueryMFT(
     wout << "\n====System Files====\n";
     ReportCfg myReportCfg = reportCfg;
     myReportCfg.readFilter = countFilter;
+    myReportCfg.skipFree = false;   // Count deleted records.
+    myReportCfg.memoryLimitMB = 0;  // Detail report walks in memory MFT.
+    myReportCfg.benchmark = false;
     myReportCfg.attribute = myReportCfg.directory = myReportCfg.mftIndex = myReportCfg.modifyTime = myReportCfg.fileSize = myReportCfg.diskSize = true;
     wonullstream wnull;
     ScanFiles(volume, phyDrv, diskInfo, myReportCfg, wnull, pStreamFilter, 0);
@@ -432,11 +455,11 @@ DWORD NtfsUtil::QueryMFT(
     {
         // read the only file detail not the file data
         MFTRecord mftRecord;
-        mftRecord.SetDriveHandle(m_hDrive);
+        mftRecord.SetReader(m_reader);
         mftRecord.SetRecordInfo((LONGLONG)m_startSector * m_bytesPerSector, m_dwMFTRecordSz, m_bytesPerCluster);
         wout << "\n====MFT StartSector:" << m_startSector << "====\n";
 
-	    for (DWORD fileOff = 0; fileOff < m_copyOfMFT.size(); fileOff += m_dwMFTRecordSz)     
+	    for (size_t fileOff = 0; fileOff + m_dwMFTRecordSz <= m_copyOfMFT.size(); fileOff += m_dwMFTRecordSz)     
 	    {		
             if (wout.bad())
                 wout.clear();
@@ -648,27 +671,6 @@ bool HasBits(TT bits, TT mask)
     return (bits & mask) != 0;
 }
 
-static int getHardLinks(const std::wstring path)
-{
-    int nLinks = 0;
-    LARGE_INTEGER fileId;
-    fileId.QuadPart = 0;
-
-    BY_HANDLE_FILE_INFORMATION ByHandleFileInformation;
-
-    Hnd fileHnd = CreateFile(path.c_str(), FILE_READ_ATTRIBUTES, 7, 0, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, 0);
-    if (fileHnd.IsValid()) {
-        if (GetFileInformationByHandle(fileHnd, &ByHandleFileInformation)) {
-            nLinks = ByHandleFileInformation.nNumberOfLinks;
-            fileId.LowPart = ByHandleFileInformation.nFileIndexLow;
-            fileId.HighPart = ByHandleFileInformation.nFileIndexHigh;
-        }
-        // CloseHandle(fileHnd);
-    }
-
-    return nLinks;
-}
-
 
 // ------------------------------------------------------------------------------------------------
 DWORD NtfsUtil::ScanFiles(
@@ -682,15 +684,16 @@ DWORD NtfsUtil::ScanFiles(
 {
     bool useVolume = true;      // false use physical drive
 
-    if (!m_hDrive.IsValid()) {
-        if (useVolume) {  
-            m_hDrive = CreateFile(volume, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0, OPEN_EXISTING, 0, NULL);
-        } else {
-            m_hDrive = CreateFile(phyDrv, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0, OPEN_EXISTING, 0, NULL);
+    if (m_reader.IsNull()) {
+        HandleReader* pHandleReader = new HandleReader();
+        m_reader = pHandleReader;
+        DWORD error = pHandleReader->Open(useVolume ? volume : phyDrv, 
+            reportCfg.directIO ? FILE_FLAG_NO_BUFFERING : 0);
+        if (error != ERROR_SUCCESS)
+        {
+            m_reader = SharePtr<VolumeReader>();
+            return (m_error = error);
         }
-	    
-        if (!m_hDrive.IsValid())
-            return (m_error = GetLastError());
     }
 
 	// ---- Set the starting sector of the NTFS
@@ -701,6 +704,44 @@ DWORD NtfsUtil::ScanFiles(
     }
 	m_bytesPerSector  = SECTOR_SIZE;
     m_slash           = reportCfg.slash;
+    m_loadConfig.workers = reportCfg.loadThreads;
+    if (reportCfg.readRequestKB != 0)
+        m_loadConfig.maxRequest = reportCfg.readRequestKB * 1024;
+    if (reportCfg.queueDepth != 0)
+        m_loadConfig.queueDepth = reportCfg.queueDepth;
+    m_skipFree        = reportCfg.skipFree && !reportCfg.deleted;
+    // Only deleted scans report free records, only MFT information counts every record.
+    if (reportCfg.queryInfo)
+        m_select = RecordClass::sAnyFile;
+    else
+        m_select = reportCfg.deleted ? RecordClass::sFree : (RecordClass::sInUse | RecordClass::sInUseDir);
+    // Only MFT information walks the records, scans keep the catalog of the files.
+    m_keepRecords = reportCfg.queryInfo;
+    m_streaming       = reportCfg.memoryLimitMB != 0 || reportCfg.benchmark;
+    m_snapshotDir     = (reportCfg.snapshotDir != NULL) ? reportCfg.snapshotDir : L"";
+    m_refreshSnapshot = reportCfg.refreshSnapshot;
+    m_snapshotMaxAge  = reportCfg.snapshotMaxAge;
+    m_retainMFT       = false;
+    if (m_keepRecords)
+        m_snapshotDir.clear();  // Snapshot holds the catalog, not the records.
+    if (reportCfg.sequential)
+    {
+        // Forward only reader, read MFT once in disk order. Directories, deleted ones too (-X),
+        // come from the load, only VCN lists (-V) read records again.
+        // $MFT:$BITMAP and snapshot check may lie behind the MFT, read every record instead.
+        m_skipFree = false;
+        m_streaming = false;
+        m_snapshotDir.clear();
+        m_retainMFT = reportCfg.showVcn;
+        m_loadConfig.queueDepth = 1;
+    }
+
+    m_pTargets = &reportCfg.targets;
+    m_targetOut.clear();
+    m_targetOut.resize(reportCfg.targets.size());
+    for (unsigned targetIdx = 1; targetIdx < reportCfg.targets.size(); targetIdx++)
+        m_targetOut[targetIdx] = new std::wostringstream();
+    m_targetHeader.assign(reportCfg.targets.size(), true);
 
     // ---- Initialize, read all MFT in to the memory and optionally filter resuls.
 	int nRet = Initialize(*reportCfg.readFilter);           
@@ -708,8 +749,261 @@ DWORD NtfsUtil::ScanFiles(
     if (nRet)
 		return (m_error = nRet);
 
-    wchar_t* separator = reportCfg.separator;
+    if (reportCfg.benchmark)
+        return (m_error = BenchmarkReads(reportCfg, wout));
+
+    if (m_streaming)
+    {
+        // ---- Read, filter and report MFT chunk by chunk.
+        nRet = StreamFiles(reportCfg, wout, pStreamFilter);
+        FlushTargets(wout);
+        if (reportCfg.loadStats)
+            ShowLoadStats(std::wcerr);
+        return (m_error = nRet);
+    }
+
+    if (reportCfg.loadStats)
+        ShowLoadStats(std::wcerr);
+
+    std::wstring heading = MakeHeading(reportCfg);
     bool drawHeader = true;
+
+    m_abort = false;
+    DWORD error = ScanCatalog(reportCfg, wout, heading, drawHeader, maxFiles, pStreamFilter);
+    if (error == (DWORD)-2)
+        return error;
+    FlushTargets(wout);
+    return (m_error = error);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Report from the file catalog built while loading, records are not kept. Rows are selected
+// on the catalog columns, only the reported ones are turned into FileInfo. Records were
+// parsed and filtered by the MFTLoader workers (-j), so the report runs on one thread.
+DWORD NtfsUtil::ScanCatalog(
+    const ReportCfg& reportCfg, 
+    std::wostream& wout, 
+    const std::wstring& heading, 
+    bool& drawHeader, 
+    DWORD maxFiles,
+    StreamFilter* pStreamFilter)
+{
+    const FileCatalog& catalog = m_entries.entries;
+    size_t rowCnt = min((size_t)maxFiles, catalog.size());
+
+    FileCatalog::Rows rows;
+    if (reportCfg.mostFragmented != 0)
+        catalog.SelectMostFragmented(rowCnt, reportCfg.mostFragmented, reportCfg.deleted, m_entries.names.data(), rows);
+    else
+        catalog.SelectActive(rowCnt, reportCfg.deleted, rows);
+
+    std::vector<FileInfo> batch;
+    std::vector<DWORD> mftIndexes;      // Of batch, to read VCN lists.
+    batch.reserve(min(rows.size(), (size_t)sReportBatch));
+    for (size_t rowIdx = 0; rowIdx < rows.size(); rowIdx++)
+    {
+        if (m_abort)
+            return (DWORD)-2;
+
+        batch.push_back(FileInfo());
+        GetEntryInfo(m_entries, rows[rowIdx], batch.back());
+        mftIndexes.push_back(catalog.m_mftIndex[rows[rowIdx]]);
+        if (batch.size() == sReportBatch || rowIdx + 1 == rows.size())
+        {
+            if (reportCfg.showVcn)
+            {
+                int nRet = ReadDataRuns(mftIndexes, batch, pStreamFilter);
+                if (nRet)
+                    return nRet;
+            }
+            OutputFiles(batch, reportCfg, wout, heading, drawHeader);
+            batch.clear();
+            mftIndexes.clear();
+        }
+    }
+
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Catalog has no data runs, read the records of files again, several reads in flight, for
+// their VCN lists. Return 0 on success, else last error.
+int NtfsUtil::ReadDataRuns(const std::vector<DWORD>& mftIndexes, std::vector<FileInfo>& files, StreamFilter* pStreamFilter)
+{
+    ReadPlan::ExtentList extents;
+    for (unsigned idx = 0; idx < mftIndexes.size(); idx++)
+    {
+        if (!GetDiskExtents((LONGLONG)mftIndexes[idx] * m_dwMFTRecordSz, m_dwMFTRecordSz, extents))
+            return ReturnError(ERROR_INVALID_BLOCK);
+    }
+
+    Buffer records;
+    int nRet = ReadPlan::ReadAll(*m_reader, extents, records, m_loadConfig.maxRequest, 
+        MFTconst::sMaxReadGap, m_loadConfig.queueDepth);
+    if (nRet)
+        return nRet;
+    if (records.size() != mftIndexes.size() * m_dwMFTRecordSz)
+        return ReturnError(ERROR_HANDLE_EOF);
+    FixupRecords(records.Data(), records.size());
+
+    for (unsigned idx = 0; idx < mftIndexes.size(); idx++)
+    {
+        MFTRecord mftRecord;
+        mftRecord.SetReader(m_reader);
+        mftRecord.SetRecordInfo((LONGLONG)m_startSector * m_bytesPerSector, m_dwMFTRecordSz, m_bytesPerCluster);
+        Buffer fileBuf = records.Region(idx * m_dwMFTRecordSz, m_dwMFTRecordSz);
+        nRet = mftRecord.ExtractStream(fileBuf, pStreamFilter);
+        if (nRet)
+            return nRet;
+        files[idx].m_fileOnDisk.swap(mftRecord.m_fileOnDisk);
+    }
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+void NtfsUtil::FlushTargets(std::wostream& wout)
+{
+    for (unsigned targetIdx = 1; targetIdx < m_targetOut.size(); targetIdx++)
+    {
+        wout << m_targetOut[targetIdx]->str();
+        m_targetOut[targetIdx]->str(L"");
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Report batch of files, or keep the most fragmented ones until the scan completes.
+void NtfsUtil::ReportFiles(
+    std::vector<FileInfo>& files, 
+    const ReportCfg& reportCfg, 
+    std::wostream& wout, 
+    const std::wstring& heading, 
+    bool& drawHeader)
+{
+    if (reportCfg.mostFragmented != 0)
+        KeepMostFragmented(files, reportCfg);
+    else
+        OutputFiles(files, reportCfg, wout, heading, drawHeader);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Fill in directory of files which will be reported, reading missing directories together,
+// then report them in order.
+void NtfsUtil::OutputFiles(
+    std::vector<FileInfo>& files, 
+    const ReportCfg& reportCfg, 
+    std::wostream& wout, 
+    const std::wstring& heading, 
+    bool& drawHeader)
+{
+    const std::vector<ReportCfg::Target>& targets = reportCfg.targets;
+    if (reportCfg.directory || reportCfg.directoryFilter || !targets.empty())
+    {
+        std::vector<DWORD> parents;
+        for (unsigned fileIdx = 0; fileIdx < files.size(); fileIdx++)
+        {
+            const FileInfo& fileInfo = files[fileIdx];
+            if (fileInfo.parentSeq != 0 && fileInfo.bDeleted == reportCfg.deleted && fileInfo.filename.length() != 0)
+                parents.push_back(fileInfo.parentSeq);
+        }
+        PrefetchDirectories(parents);
+
+        for (unsigned fileIdx = 0; fileIdx < files.size(); fileIdx++)
+        {
+            FileInfo& fileInfo = files[fileIdx];
+            if (fileInfo.parentSeq != 0 && fileInfo.bDeleted == reportCfg.deleted && fileInfo.filename.length() != 0)
+                GetDirectory(fileInfo.directory, fileInfo.parentSeq);
+        }
+    }
+
+    if (targets.empty())
+    {
+        for (unsigned fileIdx = 0; fileIdx < files.size(); fileIdx++)
+            ReportFile(files[fileIdx], reportCfg, wout, heading, drawHeader);
+        return;
+    }
+
+    for (unsigned fileIdx = 0; fileIdx < files.size(); fileIdx++)
+    {
+        const FileInfo& fileInfo = files[fileIdx];
+        for (unsigned targetIdx = 0; targetIdx < targets.size(); targetIdx++)
+        {
+            if ((fileInfo.targetMask & (1ULL << targetIdx)) == 0 
+                || !IsDirectoryMatch(*targets[targetIdx].dirFilter, fileInfo))
+                continue;
+
+            std::wostream& targetOut = (targetIdx == 0) ? wout : *m_targetOut[targetIdx];
+            bool targetHeader = m_targetHeader[targetIdx];
+            ReportFile(fileInfo, reportCfg, targetOut, heading, targetHeader);
+            m_targetHeader[targetIdx] = targetHeader;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Most fragments first, then largest gap. Ties are ordered by name and parent so the files 
+// kept do not depend on how the scan was split into batches.
+static bool MoreFragmented(const NtfsUtil::FileInfo& lhs, const NtfsUtil::FileInfo& rhs)
+{
+    if (lhs.frag.fragments != rhs.frag.fragments)
+        return lhs.frag.fragments > rhs.frag.fragments;
+    if (lhs.frag.largestGap != rhs.frag.largestGap)
+        return lhs.frag.largestGap > rhs.frag.largestGap;
+    if (lhs.filename != rhs.filename)
+        return lhs.filename < rhs.filename;
+    return lhs.parentSeq < rhs.parentSeq;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Keep fragmented files of batch, trimmed to the most fragmented once twice as many are held.
+void NtfsUtil::KeepMostFragmented(const std::vector<FileInfo>& files, const ReportCfg& reportCfg)
+{
+    for (unsigned fileIdx = 0; fileIdx < files.size(); fileIdx++)
+    {
+        const FileInfo& fileInfo = files[fileIdx];
+        if (fileInfo.frag.fragments > 1 && fileInfo.bDeleted == reportCfg.deleted && fileInfo.filename.length() != 0)
+            m_mostFragmented.push_back(fileInfo);
+    }
+
+    size_t keep = reportCfg.mostFragmented;
+    if (m_mostFragmented.size() >= 2 * keep)
+    {
+        std::nth_element(m_mostFragmented.begin(), m_mostFragmented.begin() + keep, m_mostFragmented.end(), MoreFragmented);
+        m_mostFragmented.resize(keep);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Report files kept by KeepMostFragmented, most fragmented first.
+void NtfsUtil::ReportMostFragmented(
+    const ReportCfg& reportCfg, 
+    std::wostream& wout, 
+    const std::wstring& heading, 
+    bool& drawHeader)
+{
+    if (reportCfg.mostFragmented == 0)
+        return;
+
+    std::sort(m_mostFragmented.begin(), m_mostFragmented.end(), MoreFragmented);
+    if (m_mostFragmented.size() > reportCfg.mostFragmented)
+        m_mostFragmented.resize(reportCfg.mostFragmented);
+    OutputFiles(m_mostFragmented, reportCfg, wout, heading, drawHeader);
+    m_mostFragmented.clear();
+}
+
+// ------------------------------------------------------------------------------------------------
+// Return true if file's directory passes filter, an empty filter passes all directories.
+bool NtfsUtil::IsDirectoryMatch(const FsFilter& dirFilter, const FileInfo& fileInfo)
+{
+    // Currently only the directory name is checked, record details are not used.
+    static const MFT_STANDARD sDummyAttr = MFT_STANDARD();
+    static const MFT_FILEINFO sDummyFileInfo = MFT_FILEINFO();
+    return !dirFilter.IsValid() || dirFilter.IsMatch(sDummyAttr, sDummyFileInfo, MatchInfo(NULL, &fileInfo));
+}
+
+// ------------------------------------------------------------------------------------------------
+std::wstring NtfsUtil::MakeHeading(const ReportCfg& reportCfg)
+{
+    wchar_t* separator = reportCfg.separator;
     std::wostringstream wHeading;
     if (reportCfg.mftIndex)
         wHeading << std::setw(6) << "Parent"  << separator;
@@ -729,114 +1023,107 @@ DWORD NtfsUtil::ScanFiles(
         wHeading  << " Dir" << separator << std::setw(8) << "Attribute" << separator; 
 
     if (reportCfg.nameCnt)
-        wHeading << std::setw(6) << "#Name" << separator;
+        wHeading << std::setw(6) << "#Name" << separator << std::setw(6) << "#Link" << separator;
+
+    if (reportCfg.fragInfo)
+        wHeading << std::setw(6) << "#Frag" << separator << std::setw(6) << "#Sprs" << separator 
+            << std::setw(12) << "LargestGap" << separator;
 
     wHeading << "Path\n";
+    return wHeading.str();
+}
 
-    wchar_t numStr[20];
-    m_abort = false;
-    // const DWORD sMaxFiles = (DWORD)-1;     // theoretical max file count is 0xFFFFFFFF
-	for (DWORD fileIdx = 0; fileIdx < maxFiles; fileIdx++)     
-	{								        
-		if (m_abort)
-			return (DWORD)-2;
-
-        // Get the file detail one by one.
-        NtfsUtil::FileInfo stFInfo;
-        StreamFilter streamFilter;      // TODO - fix this 
-		nRet = GetSelectedFile(fileIdx, reportCfg.postFilter, stFInfo, reportCfg.directory || reportCfg.directoryFilter, &streamFilter); 
-		if (nRet == ERROR_NO_MORE_FILES)
-			return 0;
-
-		if (nRet)
-			return (m_error = nRet);
-
-        if (stFInfo.bDeleted == reportCfg.deleted &&  stFInfo.filename.length() != 0)
-        {
-            if (reportCfg.directoryFilter)
-            {
-                // Currently only the directory name is checked via the postFilter.
-                static MFT_STANDARD sDummyAttr;
-                static MFT_FILEINFO sDummyFileInfo;
-                if (!reportCfg.postFilter->IsMatch(sDummyAttr, sDummyFileInfo, MatchInfo(NULL, & stFInfo)))
-                    continue;
-            }
+// ------------------------------------------------------------------------------------------------
+// Output one file if it matches report filters, heading is output before first file.
+void NtfsUtil::ReportFile(
+    const FileInfo& stFInfo, 
+    const ReportCfg& reportCfg, 
+    std::wostream& wout, 
+    const std::wstring& heading, 
+    bool& drawHeader)
+{
+    if (stFInfo.bDeleted != reportCfg.deleted || stFInfo.filename.length() == 0)
+        return;
 
-            bool goodFile = HasBits(stFInfo.dwAttributes, reportCfg.attributes);
-            goodFile |= (stFInfo.dwAttributes == 0 && HasBits(reportCfg.attributes, (DWORD)eSystem));
-            goodFile |= ((stFInfo.streamCnt > 1 || stFInfo.nameCnt > 1) && reportCfg.streamCnt);
-            goodFile |= (stFInfo.bSparse && HasBits(reportCfg.attributes, (DWORD)eSystem));
+    wchar_t* separator = reportCfg.separator;
+    wchar_t numStr[20];
 
-            if (!goodFile)
-                continue;
+    if (reportCfg.directoryFilter && !IsDirectoryMatch(*reportCfg.postFilter, stFInfo))
+        return;
 
-            if (wout.bad())
-                wout.clear();
+    bool goodFile = HasBits(stFInfo.dwAttributes, reportCfg.attributes);
+    goodFile |= (stFInfo.dwAttributes == 0 && HasBits(reportCfg.attributes, (DWORD)eSystem));
+    goodFile |= ((stFInfo.streamCnt > 1 || stFInfo.nameCnt > 1) && reportCfg.streamCnt);
+    goodFile |= (stFInfo.bSparse && HasBits(reportCfg.attributes, (DWORD)eSystem));
 
-            if (drawHeader)
-            {
-                drawHeader = false;
-                wout << wHeading.str().c_str();
-            }
+    if (!goodFile)
+        return;
 
-            // wout  << std::setw(5) << fileIdx << separator;
+    if (wout.bad())
+        wout.clear();
 
-            if (reportCfg.mftIndex)
-                wout << std::setw(6) << stFInfo.parentSeq  << separator;
+    if (drawHeader)
+    {
+        drawHeader = false;
+        wout << heading.c_str();
+    }
 
-            if (reportCfg.streamCnt)
-                wout << std::setw(6) << stFInfo.streamCnt  << separator;
+    // wout  << std::setw(5) << fileIdx << separator;
 
-            if (reportCfg.modifyTime)
-                wout << *(FILETIME*)&stFInfo.n64Modify << separator;
+    if (reportCfg.mftIndex)
+        wout << std::setw(6) << stFInfo.parentSeq  << separator;
 
-            if (reportCfg.diskSize)
-            {
-                wout << std::setw(19) << LocaleFmt::snprintf(numStr, ARRAYSIZE(numStr), L"%lld", stFInfo.diskSize);
-                wout << (stFInfo.bSparse ? "%" : " ");
-                wout << separator;
-            }
-            if (reportCfg.fileSize) {
-                wout << std::setw(19) << LocaleFmt::snprintf(numStr, ARRAYSIZE(numStr), L"%lld", stFInfo.fileSize);
-                wout << (stFInfo.bSparse ? "%" : " ");
-                wout << separator;
-            }
+    if (reportCfg.streamCnt)
+        wout << std::setw(6) << stFInfo.streamCnt  << separator;
 
-            if (reportCfg.attribute) {
-                // TODO - show hardlink count. 
-                // int nlinks = getHardLinks(stFInfo.directory + m_slash + stFInfo.filename);
-                _snwprintf_s(numStr, ARRAYSIZE(numStr), L"~~%3d", (unsigned)stFInfo.streamCnt);
-                wout
-                    << ((eDirectory & stFInfo.dwAttributes) != 0 ? L" Dir " : (stFInfo.streamCnt > 1 ? numStr : L"     "))
-                    << separator
-                    << std::setw(8) << std::hex << stFInfo.dwAttributes << std::dec
-                    << separator;
-            }
+    if (reportCfg.modifyTime)
+        wout << *(FILETIME*)&stFInfo.n64Modify << separator;
 
-            if (reportCfg.showVcn)
-                if (stFInfo.m_fileOnDisk.size())
-                {
-                    wout << " VCN(" << stFInfo.m_fileOnDisk.size() << ") ";
-                    for (unsigned vcnIdx = 0; vcnIdx != stFInfo.m_fileOnDisk.size(); ++vcnIdx)
-                    {
-                        wout << stFInfo.m_fileOnDisk[vcnIdx].first << "#" 
-                            << stFInfo.m_fileOnDisk[vcnIdx].second / m_bytesPerCluster
-                            << " ";
-                    }
-                }
+    if (reportCfg.diskSize)
+    {
+        wout << std::setw(19) << LocaleFmt::snprintf(numStr, ARRAYSIZE(numStr), L"%lld", stFInfo.diskSize);
+        wout << (stFInfo.bSparse ? "%" : " ");
+        wout << separator;
+    }
+    if (reportCfg.fileSize) {
+        wout << std::setw(19) << LocaleFmt::snprintf(numStr, ARRAYSIZE(numStr), L"%lld", stFInfo.fileSize);
+        wout << (stFInfo.bSparse ? "%" : " ");
+        wout << separator;
+    }
 
-            if (reportCfg.nameCnt)
-                wout << std::setw(6) << stFInfo.nameCnt  << separator;
+    if (reportCfg.attribute) {
+        _snwprintf_s(numStr, ARRAYSIZE(numStr), L"~~%3d", (unsigned)stFInfo.streamCnt);
+        wout
+            << ((eDirectory & stFInfo.dwAttributes) != 0 ? L" Dir " : (stFInfo.streamCnt > 1 ? numStr : L"     "))
+            << separator
+            << std::setw(8) << std::hex << stFInfo.dwAttributes << std::dec
+            << separator;
+    }
 
-            wout << reportCfg.volume;
-            if (reportCfg.directory)
-                wout << stFInfo.directory << m_slash;
-            wout << stFInfo.filename;
-            wout << std::endl;
+    if (reportCfg.showVcn)
+        if (stFInfo.m_fileOnDisk.size())
+        {
+            wout << " VCN(" << stFInfo.m_fileOnDisk.size() << ") ";
+            for (unsigned vcnIdx = 0; vcnIdx != stFInfo.m_fileOnDisk.size(); ++vcnIdx)
+            {
+                wout << stFInfo.m_fileOnDisk[vcnIdx].first << "#" 
+                    << stFInfo.m_fileOnDisk[vcnIdx].second / m_bytesPerCluster
+                    << " ";
+            }
         }
-	}
 
-    return ERROR_SUCCESS;
+    if (reportCfg.nameCnt)
+        wout << std::setw(6) << stFInfo.nameCnt  << separator << std::setw(6) << stFInfo.hardLinks << separator;
+
+    if (reportCfg.fragInfo)
+        wout << std::setw(6) << stFInfo.frag.fragments << separator << std::setw(6) << stFInfo.frag.sparseRuns << separator
+            << std::setw(12) << stFInfo.frag.largestGap << separator;
+
+    wout << reportCfg.volume;
+    if (reportCfg.directory)
+        wout << stFInfo.directory << m_slash;
+    wout << stFInfo.filename;
+    wout << std::endl;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -852,19 +1139,16 @@ DWORD NtfsUtil::ScanFiles(
 //
 int NtfsUtil::Initialize(const FsFilter& filter)
 {
-	LARGE_INTEGER n84StartPos;
-    n84StartPos.QuadPart = (LONGLONG)m_startSector * m_bytesPerSector;
-
-	// Point to the starting NTFS volume sector in the physical drive
-	SetFilePointer(m_hDrive, n84StartPos.LowPart, &n84StartPos.HighPart, FILE_BEGIN);
-    m_error = GetLastError();
+	LONGLONG n64StartPos = (LONGLONG)m_startSector * m_bytesPerSector;
 
-	// Read the boot sector for the MFT infomation
+	// Read the boot sector, at the starting NTFS volume sector, for the MFT infomation
 	NTFS_PART_BOOT_SEC ntfsBS;
 	DWORD dwBytes;
-	int nRet = ReadFile(m_hDrive, &ntfsBS, sizeof(NTFS_PART_BOOT_SEC), &dwBytes, NULL);
-	if (!nRet)
-		return GetLastError();
+	int nRet = m_reader->Read(n64StartPos, &ntfsBS, sizeof(NTFS_PART_BOOT_SEC), dwBytes);
+	if (nRet)
+		return nRet;
+    if (dwBytes != sizeof(NTFS_PART_BOOT_SEC))
+        return ReturnError(ERROR_HANDLE_EOF);
 
     unsigned int sz2 = sizeof(NTFS_PART_BOOT_SEC::NTFS_BPB);  
     assert(sz2 == 73);
@@ -883,9 +1167,24 @@ int NtfsUtil::Initialize(const FsFilter& filter)
 	/// Cluster is the logical entity
 	///  which is made up of several sectors (a physical entity) 
 	m_bytesPerCluster = ntfsBS.bpb.sectorsPerCluster * ntfsBS.bpb.bytesPerSector;	
-
-	m_dwMFTRecordSz = 0x01 << ((-1)*((char)ntfsBS.bpb.clustersPerFileRecord));
-    m_dwMFTRecordSz = 1024;  
+    m_volumeSerial = ntfsBS.bpb.serialNumber;
+
+    // Unbuffered reads are padded to whole sectors.
+    m_reader->SetSectorSize(ntfsBS.bpb.bytesPerSector);
+    m_sectorSize = ntfsBS.bpb.bytesPerSector;
+
+    // Positive is clusters per record, negative is log2 of record size (ex: -10 = 1 KB).
+    // Usual sizes are 1 KB, and 4 KB on 4K sector disks.
+    char clustersPerRecord = (char)ntfsBS.bpb.clustersPerFileRecord;
+    if (clustersPerRecord > 0)
+        m_dwMFTRecordSz = clustersPerRecord * m_bytesPerCluster;
+    else if (clustersPerRecord >= -16)
+        m_dwMFTRecordSz = 0x01 << -clustersPerRecord;
+    else
+        m_dwMFTRecordSz = 0;
+    if (m_dwMFTRecordSz < sizeof(MFT_FILE_HEADER) || m_dwMFTRecordSz > 0x10000 
+        || (m_dwMFTRecordSz & (m_dwMFTRecordSz - 1)) != 0 || m_bytesPerCluster == 0)
+        return ReturnError(ERROR_INVALID_DRIVE);
 	m_oneMFTRecord.resize(m_dwMFTRecordSz);
 
 	// Load entire MFT into m_copyOfMFT
@@ -913,52 +1212,497 @@ int NtfsUtil::LoadMFT(LONGLONG startCluster, const FsFilter& filter)
 	int nRet;
 
 	// NTFS starting point
-	LARGE_INTEGER n64Pos;
-    n64Pos.QuadPart = (LONGLONG) m_startSector * m_bytesPerSector;  // only used if reading from PhysicalDevice
+	LONGLONG n64StartPos = (LONGLONG) m_startSector * m_bytesPerSector;  // only used if reading from PhysicalDevice
 
     // MFT starting point
-    n64Pos.QuadPart += (LONGLONG)startCluster * m_bytesPerCluster;
-	//  Set the pointer to the MFT start
-	nRet = SetFilePointer(m_hDrive, n64Pos.LowPart, &n64Pos.HighPart, FILE_BEGIN);
-	if (nRet == 0xFFFFFFFF)
-		return GetLastError();
+    LONGLONG n64Pos = n64StartPos + (LONGLONG)startCluster * m_bytesPerCluster;
 
 	// Reading the first record in the NTFS table.
 	// The first record in the NTFS is always MFT record.
 	DWORD dwBytes;
     BYTE* pMFTRecord = &m_oneMFTRecord[0];
-	nRet = ReadFile(m_hDrive, pMFTRecord, m_dwMFTRecordSz, &dwBytes, NULL);
-	if (!nRet)
-		return GetLastError();
+	nRet = m_reader->Read(n64Pos, pMFTRecord, m_dwMFTRecordSz, dwBytes);
+	if (nRet)
+		return nRet;
+    if (dwBytes != m_dwMFTRecordSz)
+        return ReturnError(ERROR_HANDLE_EOF);
 
     assert(sizeof(MFT_FILE_HEADER) <= m_dwMFTRecordSz);
 	m_NtfsMFT = *(MFT_FILE_HEADER*)pMFTRecord;
 
 	// Now extract the MFT record just like the other MFT table records
 	MFTRecord mftRecord;
-	mftRecord.SetDriveHandle(m_hDrive);
-	mftRecord.SetRecordInfo((LONGLONG)m_startSector * m_bytesPerSector, m_dwMFTRecordSz, m_bytesPerCluster);
-	nRet = mftRecord.ExtractMFT(m_oneMFTRecord, filter);
-	if (nRet)
-		return nRet;
+	mftRecord.SetReader(m_reader);
+	mftRecord.SetRecordInfo(n64StartPos, m_dwMFTRecordSz, m_bytesPerCluster);
 
-	const wchar_t sMFTName[] = L"$MFT";
-	if (memcmp(mftRecord.m_attrFilename.wFilename, sMFTName, 8))
-		return ReturnError(ERROR_BAD_DEVICE);    // no MFT file available
+    Buffer mftHeader(m_oneMFTRecord);
+    FixupRecords(mftHeader.Data(), mftHeader.size());
+    nRet = mftRecord.ExtractFile(mftHeader, false);
+    if (nRet)
+        return nRet;
+
+    m_copyOfMFT.clear();
+    m_entries.clear();
+    m_fromSnapshot = false;
+    m_mftBitmap.clear();
+    m_loadStats = MFTLoader::Stats();
+    ZeroMemory(m_typeCnt, sizeof(m_typeCnt));
+    m_dirTable.Clear();
+
+    // $MFT record's own type counts.
+    for (unsigned mftRecIdx = 1; mftRecIdx < 16; mftRecIdx++)
+        m_typeCnt[mftRecIdx] += mftRecord.GetTypeCnts()[mftRecIdx];
+
+    // Large fragmented $MFT keeps the rest of its data runs in extension records.
+    if (mftRecord.m_hasAttrList)
+    {
+        nRet = AddMFTExtensionRuns(mftRecord);
+        if (nRet)
+            return nRet;
+    }
 
-	// Take data(m_outFileData) is special since it is the data of entire MFT file
-    m_copyOfMFT.swap(mftRecord.m_outFileData);   
+    // Indexes taken from records (parents) are only used below the record count.
+    LONGLONG mftBytes = 0;
+    for (unsigned runIdx = 0; runIdx < mftRecord.m_fileOnDisk.size(); runIdx++)
+        mftBytes += mftRecord.m_fileOnDisk[runIdx].second;
+    m_mftRecords = (DWORD)min(mftBytes / m_dwMFTRecordSz, (LONGLONG)MAXDWORD);
+    m_dirTable.SetLimit(m_mftRecords);
+
+    if (m_streaming)
+    {
+        // MFT is read later, chunk by chunk, by StreamFiles.
+        if (m_skipFree)
+            LoadMFTBitmap(mftHeader, m_mftBitmap);
+        m_fileOnDisk.swap(mftRecord.m_fileOnDisk);
+        return CheckMFTName(mftRecord);
+    }
+
+    // Reported records are read again for their VCN list.
+    for (unsigned runIdx = 0; m_retainMFT && runIdx < mftRecord.m_fileOnDisk.size(); runIdx++)
+    {
+        m_reader->Retain(n64StartPos + mftRecord.m_fileOnDisk[runIdx].first * m_bytesPerCluster, 
+            mftRecord.m_fileOnDisk[runIdx].second);
+    }
+
+    // Reuse catalog of a recent scan.
+    if (!m_snapshotDir.empty())
+    {
+        nRet = LoadSnapshot(mftHeader, mftRecord.m_fileOnDisk, filter);
+        if (nRet == ERROR_SUCCESS)
+        {
+            m_fileOnDisk.swap(mftRecord.m_fileOnDisk);
+            return CheckMFTName(mftRecord);
+        }
+        std::wcerr << "Warning MFT snapshot not used, error " << nRet << std::endl;
+        m_copyOfMFT.clear();
+        m_entries.clear();
+        m_dirTable.Clear();
+        m_fromSnapshot = false;
+        m_mftBitmap.clear();
+        m_loadStats = MFTLoader::Stats();
+    }
+
+    // Active file scans only need clusters holding in use records.
+    if (m_skipFree)
+        LoadMFTBitmap(mftHeader, m_mftBitmap);
+
+    // Overlap reading the MFT with parsing and filtering its records.
+    MFTLoader loader(m_reader, n64StartPos, m_dwMFTRecordSz, m_bytesPerCluster);
+    loader.SetConfig(m_loadConfig);
+    loader.SetSectorSize(m_sectorSize);
+    if (!m_mftBitmap.empty())
+        loader.SetBitmap(m_mftBitmap);
+    nRet = LoadRecords(loader, mftRecord.m_fileOnDisk, filter);
+    if (nRet)
+        return nRet;
 
     // Take file's on disk layout.
     m_fileOnDisk.swap(mftRecord.m_fileOnDisk);
-    m_dirMap.clear();
+	return CheckMFTName(mftRecord);
+}
+
+// ------------------------------------------------------------------------------------------------
+// $ATTRIBUTE_LIST of $MFT lists the extension record holding each later segment of its $DATA,
+// a segment holds the data runs from its start VCN. Extension records lie in the part of
+// the MFT described by the runs found so far.
+int NtfsUtil::AddMFTExtensionRuns(MFTRecord& mftRecord)
+{
+    MFTRecord::AttrList attrList;
+    int nRet = mftRecord.GetAttrList(attrList);
+    if (nRet)
+        return nRet;
+
+    // (startVCN, mftIndex) of unnamed $DATA segments after the first.
+    std::vector<std::pair<LONGLONG, DWORD>> segments;
+    for (unsigned listIdx = 0; listIdx < attrList.size(); listIdx++)
+    {
+        const MFTRecord::AttrListEntry& entry = attrList[listIdx];
+        if (entry.type == MFTconst::sDATA && entry.nameLen == 0 && entry.startVCN != 0 && entry.mftIndex != 0)
+            segments.push_back(std::make_pair(entry.startVCN, entry.mftIndex));
+    }
+    std::sort(segments.begin(), segments.end());
+
+    for (unsigned segIdx = 0; segIdx < segments.size(); segIdx++)
+    {
+        m_fileOnDisk = mftRecord.m_fileOnDisk;      // Used by ReadMFTRecord to locate record.
+        MFTRecord extRecord;
+        nRet = ReadMFTRecord(segments[segIdx].second, extRecord);
+        if (nRet)
+            break;
+        mftRecord.m_fileOnDisk.insert(mftRecord.m_fileOnDisk.end(), 
+            extRecord.m_fileOnDisk.begin(), extRecord.m_fileOnDisk.end());
+    }
+    m_fileOnDisk.clear();
+    return nRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Scans keep the catalog of the files which pass filter, not their records. MFT information 
+// (query) keeps the records, its detail report walks them.
+int NtfsUtil::LoadRecords(MFTLoader& loader, const MFTRecord::FileOnDiskList& runs, const FsFilter& filter)
+{
+    loader.SetTargets(TargetFilters());
+    loader.SetSelect(m_select);
+    loader.SetDirTable(&m_dirTable);
+    int nRet = m_keepRecords ? loader.Load(runs, filter, m_copyOfMFT) : loader.Load(runs, filter, m_entries);
+    if (nRet)
+        return nRet;
+
+    m_loadStats = loader.GetStats();
+    for (unsigned mftRecIdx = 1; mftRecIdx < 16; mftRecIdx++)
+        m_typeCnt[mftRecIdx] += loader.GetTypeCnts()[mftRecIdx];
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Snapshot holds the catalog of every file (every in use file with m_skipFree) and the 
+// directory table, the filter is applied to the loaded rows. Its key is the volume and the
+// layout of its MFT, a live volume logs changes all the time, so a snapshot is reused until
+// it is m_snapshotMaxAge seconds old. Changes made since are not seen, use refresh.
+int NtfsUtil::LoadSnapshot(const Buffer& mftHeader, const MFTRecord::FileOnDiskList& runs, const FsFilter& filter)
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    MFTSnapshot::Key key;
+    key.serialNumber = m_volumeSerial;
+    key.mftLsn = m_NtfsMFT.n64LogSeqNumber;
+    key.recordCount = m_mftRecords;
+    key.recordSize = m_dwMFTRecordSz;
+    key.skipFree = m_skipFree ? 1 : 0;
+    std::wstring path = MFTSnapshot::MakePath(m_snapshotDir, key);
+
+    LONGLONG bytes = 0;
+    if (!m_refreshSnapshot 
+        && MFTSnapshot::Read(path.c_str(), key, m_snapshotMaxAge, m_entries, m_dirTable, bytes) == ERROR_SUCCESS)
+    {
+        m_fromSnapshot = true;
+        m_loadStats = MFTLoader::Stats();
+        m_loadStats.bytesRead = bytes;
+        m_loadStats.records = m_entries.entries.size();
+    }
+    else
+    {
+        // Catalog every file, filter is applied below as for a loaded snapshot.
+        int nRet = m_skipFree ? LoadMFTBitmap(mftHeader, m_mftBitmap) : ERROR_SUCCESS;
+        if (nRet)
+            return nRet;
+
+        MFTLoader loader(m_reader, (LONGLONG)m_startSector * m_bytesPerSector, m_dwMFTRecordSz, m_bytesPerCluster);
+        loader.SetConfig(m_loadConfig);
+        loader.SetSectorSize(m_sectorSize);
+        if (!m_mftBitmap.empty())
+            loader.SetBitmap(m_mftBitmap);
+        loader.SetSelect(m_skipFree ? (RecordClass::sInUse | RecordClass::sInUseDir) : RecordClass::sAnyFile);
+        loader.SetDirTable(&m_dirTable);
+
+        AndFilter noFilter;
+        nRet = loader.Load(runs, noFilter, m_entries);
+        if (nRet)
+            return nRet;
+
+        m_loadStats = loader.GetStats();
+        for (unsigned mftRecIdx = 1; mftRecIdx < 16; mftRecIdx++)
+            m_typeCnt[mftRecIdx] += loader.GetTypeCnts()[mftRecIdx];
+
+        // Scan goes on without a snapshot.
+        nRet = MFTSnapshot::Write(path.c_str(), key, m_entries, m_dirTable);
+        if (nRet)
+            std::wcerr << "Warning MFT snapshot not written, error " << nRet << std::endl;
+    }
 
-    // Copy MFT type count info.
-    memcpy(m_typeCnt,  mftRecord.GetTypeCnts(), sizeof(m_typeCnt));
+    MFTRecord::FilterList targets = TargetFilters();
+    m_entries.FilterRows(filter, (m_select & (RecordClass::sInUse | RecordClass::sInUseDir)) != 0,
+        (m_select & RecordClass::sFree) != 0, &targets);
+    m_loadStats.kept = m_entries.entries.size();
+    m_loadStats.totalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return ERROR_SUCCESS;
+}
 
+// ------------------------------------------------------------------------------------------------
+int NtfsUtil::CheckMFTName(const MFTRecord& mftRecord)
+{
+	const wchar_t sMFTName[] = L"$MFT";
+	if (memcmp(mftRecord.m_attrFilename.wFilename, sMFTName, 8))
+		return ReturnError(ERROR_BAD_DEVICE);    // no MFT file available
 	return ERROR_SUCCESS;
 }
 
+// ------------------------------------------------------------------------------------------------
+// Receive MFT chunks from MFTLoader and report matching files, only the directory table
+// is kept in memory.
+class NtfsUtil::StreamSink : public MFTSink
+{
+public:
+    StreamSink(NtfsUtil& ntfsUtil, const ReportCfg& reportCfg, std::wostream& wout, StreamFilter* pStreamFilter) :
+        m_ntfsUtil(ntfsUtil), m_reportCfg(reportCfg), m_wout(wout), m_pStreamFilter(pStreamFilter),
+        m_heading(MakeHeading(reportCfg)), m_drawHeader(true)
+    { }
+
+    virtual DWORD OnRecords(const DirTable::EntryList& dirs, const MFTEntryList& entries, BYTE* pData, DWORD len)
+    {
+        m_ntfsUtil.m_dirTable.Add(dirs);
+
+        // Records were parsed while filtering, only VCN lists need the record again.
+        // Entries are in record order, they hold the MFT index of each record.
+        DWORD recSize = m_ntfsUtil.m_dwMFTRecordSz;
+        if (entries.entries.size() != len / recSize)
+            return ReturnError(ERROR_INVALID_DATA);
+        bool useEntries = !m_reportCfg.showVcn;
+        m_batch.clear();
+        for (DWORD off = 0; off + recSize <= len; off += recSize)
+        {
+            if (m_ntfsUtil.m_abort)
+                return ERROR_CANCELLED;
+
+            m_batch.push_back(NtfsUtil::FileInfo());
+            if (useEntries)
+            {
+                GetEntryInfo(entries, off / recSize, m_batch.back());
+                continue;
+            }
+            int nRet = m_ntfsUtil.GetFileInfo(Block(pData + off, recSize), entries.entries.m_mftIndex[off / recSize], 
+                m_batch.back(), false, m_pStreamFilter);
+            if (nRet)
+                return nRet;
+        }
+
+        m_ntfsUtil.ReportFiles(m_batch, m_reportCfg, m_wout, m_heading, m_drawHeader);
+        return ERROR_SUCCESS;
+    }
+
+    // Report files held until the scan completes.
+    void Finish()
+    {
+        m_ntfsUtil.ReportMostFragmented(m_reportCfg, m_wout, m_heading, m_drawHeader);
+    }
+
+private:
+    NtfsUtil&           m_ntfsUtil;
+    const ReportCfg&    m_reportCfg;
+    std::wostream&      m_wout;
+    StreamFilter*       m_pStreamFilter;
+    std::wstring        m_heading;
+    bool                m_drawHeader;
+    std::vector<NtfsUtil::FileInfo> m_batch;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Bounded memory scan, read MFT in chunks, report matches as each chunk is filtered.
+// Memory limit is split between read buffers and directory table.
+DWORD NtfsUtil::StreamFiles(const ReportCfg& reportCfg, std::wostream& wout, StreamFilter* pStreamFilter)
+{
+    MFTLoader::Config config = m_loadConfig;
+    config.buffers = max(config.workers, 1u) + max(config.queueDepth, 1u) + 1;
+    DWORD bufferLimit = (DWORD)min((ULONGLONG)reportCfg.memoryLimitMB * (1024 * 1024 / 2), (ULONGLONG)0x7fffffff);
+    config.chunkSize = min(config.chunkSize, bufferLimit / config.buffers);
+    // Keep MFT order and one chunk per read, so pending chunks do not grow past the limit.
+    config.maxRequest = config.chunkSize;
+    config.sortByLCN = false;
+
+    MFTLoader loader(m_reader, (LONGLONG)m_startSector * m_bytesPerSector, m_dwMFTRecordSz, m_bytesPerCluster);
+    loader.SetConfig(config);
+    loader.SetSectorSize(m_sectorSize);
+    if (!m_mftBitmap.empty())
+        loader.SetBitmap(m_mftBitmap);
+
+    StreamSink streamSink(*this, reportCfg, wout, pStreamFilter);
+    loader.SetSink(&streamSink);
+    loader.SetTargets(TargetFilters());
+    loader.SetSelect(m_select);
+
+    m_abort = false;
+    Buffer noCopy;      // Records go to streamSink, nothing is appended.
+    int nRet = loader.Load(m_fileOnDisk, *reportCfg.readFilter, noCopy);
+    if (nRet == ERROR_SUCCESS)
+        streamSink.Finish();
+
+    m_loadStats = loader.GetStats();
+    for (unsigned mftRecIdx = 1; mftRecIdx < 16; mftRecIdx++)
+        m_typeCnt[mftRecIdx] += loader.GetTypeCnts()[mftRecIdx];
+
+    if (m_dirTable.MemorySize() > (size_t)reportCfg.memoryLimitMB * (1024 * 1024 / 2))
+        std::wcerr << "Warning directory table " << m_dirTable.MemorySize() / (1024 * 1024) 
+            << " MB exceeds half of memory limit\n";
+
+    return nRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Read unnamed $BITMAP attribute of $MFT record, one bit per MFT record, set if record in use.
+// Return 0 on success, else last error.
+int NtfsUtil::LoadMFTBitmap(const Buffer& mftHeader, Buffer& bitmap)
+{
+    MFTRecord mftRecord;
+    mftRecord.SetReader(m_reader);
+    mftRecord.SetRecordInfo((LONGLONG)m_startSector * m_bytesPerSector, m_dwMFTRecordSz, m_bytesPerCluster);
+
+    MFTRecord::ItemList itemList;
+    int nRet = mftRecord.ExtractItems(mftHeader, itemList);
+    if (nRet)
+        return nRet;
+
+    for (unsigned itemIdx = 0; itemIdx != itemList.size(); itemIdx++)
+    {
+        const MFTRecord::MFTitem& item = itemList[itemIdx];
+        if (item.type == MFTconst::sBITMAP && item.pNTFSAttribute->uchNameLength == 0)
+        {
+            const BYTE* pBits = (const BYTE*)item.data.OutVPtr(0);
+            bitmap.assign(pBits, pBits + item.data.size());
+            return ERROR_SUCCESS;
+        }
+    }
+
+    return ReturnError(ERROR_NOT_FOUND);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Report time spent loading MFT, used to benchmark reader and parser threads.
+void NtfsUtil::ShowLoadStats(std::wostream& wout) const
+{
+    const MFTLoader::Stats& stats = m_loadStats;
+    double mbytes = stats.bytesRead / (1024.0 * 1024.0);
+
+    std::streamsize precision = wout.precision(1);
+    wout << std::fixed
+        << L"MFT load " << mbytes << L" MB"
+        << (m_fromSnapshot ? L" from snapshot" : L"")
+        << L", records " << stats.records
+        << L", kept " << stats.kept
+        << L", bad " << stats.badRecords
+        << L", torn " << stats.tornRecords
+        << L", skipped " << stats.bytesSkipped / (1024.0 * 1024.0) << L" MB free"
+        << L", requests " << stats.requests
+        << L", gaps " << stats.gapBytes / (1024.0 * 1024.0) << L" MB"
+        << L", workers " << stats.workers
+        << L", queue depth " << stats.queueDepth
+        << L", read " << stats.readMs << L" ms"
+        << L", parse " << stats.parseMs << L" ms"
+        << L", total " << stats.totalMs << L" ms";
+    if (stats.totalMs > 0)
+        wout << L", " << mbytes * 1000 / stats.totalMs << L" MB/s";
+    wout << std::endl;
+    wout.unsetf(std::ios::fixed);
+    wout.precision(precision);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Read the $MFT at queue depth 1, 4, 16 and 64 and report throughput. Each depth reads a 
+// different part of the MFT so earlier passes do not warm the cache for later ones.
+DWORD NtfsUtil::BenchmarkReads(const ReportCfg& reportCfg, std::wostream& wout)
+{
+    typedef std::chrono::steady_clock Clock;
+    static const unsigned sDepths[] = { 1, 4, 16, 64 };
+    const LONGLONG sMaxPassBytes = 256LL << 20;
+
+    DWORD reqSize = (reportCfg.readRequestKB != 0) ? reportCfg.readRequestKB * 1024 : (128 << 10);
+    reqSize = max(reqSize / m_bytesPerCluster, 1u) * m_bytesPerCluster;
+
+    // Split $MFT data runs into requests.
+    LONGLONG n64StartPos = (LONGLONG)m_startSector * m_bytesPerSector;
+    ReadPlan::ExtentList extents;
+    LONGLONG n64Total = 0;
+    for (unsigned runIdx = 0; runIdx < m_fileOnDisk.size(); runIdx++)
+    {
+        LONGLONG n64Pos = n64StartPos + m_fileOnDisk[runIdx].first * m_bytesPerCluster;
+        for (LONGLONG n64Off = 0; n64Off < m_fileOnDisk[runIdx].second; n64Off += reqSize)
+        {
+            ReadPlan::Extent extent;
+            extent.pos = n64Pos + n64Off;
+            extent.len = (DWORD)min((LONGLONG)reqSize, m_fileOnDisk[runIdx].second - n64Off);
+            extents.push_back(extent);
+            n64Total += extent.len;
+        }
+    }
+    if (extents.empty())
+        return ReturnError(ERROR_HANDLE_EOF);
+
+    LONGLONG passBytes = max(min(n64Total / ARRAYSIZE(sDepths), sMaxPassBytes), (LONGLONG)reqSize);
+
+    wout << L"Read benchmark, " << reqSize / 1024 << L" KB requests, "
+        << (m_reader->OverlappedHandle() != INVALID_HANDLE_VALUE ? L"overlapped I/O" : L"thread pool")
+        << (m_reader->Alignment() > 1 ? L", unbuffered" : L"")
+        << L", $MFT " << n64Total / (1024 * 1024) << L" MB\n";
+    wout << std::setw(6) << L"Depth" << std::setw(10) << L"MB" << std::setw(10) << L"ms" 
+        << std::setw(10) << L"MB/s" << std::setw(10) << L"IOPS" << std::endl;
+
+    size_t extentIdx = 0;
+    for (unsigned depthIdx = 0; depthIdx < ARRAYSIZE(sDepths); depthIdx++)
+    {
+        AsyncReader asyncReader(*m_reader, sDepths[depthIdx]);
+        std::vector<AlignedBuffer> buffers(asyncReader.QueueDepth());
+        for (unsigned bufIdx = 0; bufIdx < buffers.size(); bufIdx++)
+            buffers[bufIdx].resize(reqSize);
+
+        LONGLONG submitted = 0;
+        LONGLONG bytesRead = 0;
+        LONGLONG reads = 0;
+        size_t submitCnt = 0;
+        Clock::time_point start = Clock::now();
+        while (submitted < passBytes || asyncReader.Pending() != 0)
+        {
+            if (submitted < passBytes && !asyncReader.IsFull())
+            {
+                if (extentIdx == extents.size())
+                    extentIdx = 0;      // Small MFT, read it again.
+                const ReadPlan::Extent& extent = extents[extentIdx++];
+                DWORD error = asyncReader.Submit(extent.pos, buffers[submitCnt++ % buffers.size()].Data(), extent.len, 0);
+                if (error != ERROR_SUCCESS)
+                {
+                    asyncReader.Drain();
+                    return error;
+                }
+                submitted += extent.len;
+                continue;
+            }
+
+            AsyncReader::Completion done;
+            DWORD error = asyncReader.Wait(done);
+            if (error != ERROR_SUCCESS)
+            {
+                asyncReader.Drain();
+                return error;
+            }
+            bytesRead += done.outLen;
+            reads++;
+        }
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        double mbytes = bytesRead / (1024.0 * 1024.0);
+        std::streamsize precision = wout.precision(1);
+        wout << std::fixed << std::setw(6) << sDepths[depthIdx] 
+            << std::setw(10) << mbytes 
+            << std::setw(10) << ms
+            << std::setw(10) << (ms > 0 ? mbytes * 1000 / ms : 0.0)
+            << std::setw(10) << (ms > 0 ? reads * 1000 / ms : 0.0)
+            << std::endl;
+        wout.unsetf(std::ios::fixed);
+        wout.precision(precision);
+    }
+
+    return ERROR_SUCCESS;
+}
+
 #if 0
 // ------------------------------------------------------------------------------------------------
 /// this function if suceeded it will allocate the buffer and passed to the caller
@@ -1030,31 +1774,33 @@ int NtfsUtil::GetFileDetail(DWORD nFileSeq, FileInfo& stFileInfo)
 #endif
 
 // ------------------------------------------------------------------------------------------------
-int NtfsUtil::GetSelectedFile(
-    DWORD nFileSeq, 
-    const SharePtr<FsFilter>& /* filter */, 
+int NtfsUtil::GetFileInfo(
+    const Block& mftBlock,
+    DWORD mftIndex,
     FileInfo& stFileInfo,
     bool getDir,
     StreamFilter* pStreamFilter)
 {
 	int nRet;
 
-	if (!m_bInitialized)
-		return ReturnError(ERROR_INVALID_ACCESS);
-
-	if ((nFileSeq * m_dwMFTRecordSz + m_dwMFTRecordSz) > m_copyOfMFT.size())
-		return ERROR_NO_MORE_FILES;
-
-	// Set mftBlock to point to the next mft record.
-    Block mftBlock(&m_copyOfMFT[nFileSeq * m_dwMFTRecordSz], m_dwMFTRecordSz);
+    // Unused, bad (see RecordFixup) and extension records are not files, nothing is reported.
+    const MFT_FILE_HEADER* pNtfsMFT = mftBlock.OutPtr<MFT_FILE_HEADER>(0);
+    if (memcmp(pNtfsMFT->szSignature, "FILE", 4) != 0 || pNtfsMFT->n64BaseMftRec != 0)
+    {
+        stFileInfo.filename.clear();
+        stFileInfo.targetMask = 0;
+        return ERROR_SUCCESS;
+    }
 
 	// read the only file detail not the file data
 	MFTRecord mftRecord;
-	mftRecord.SetDriveHandle(m_hDrive);
+	mftRecord.SetReader(m_reader);
 	mftRecord.SetRecordInfo((LONGLONG)m_startSector * m_bytesPerSector, m_dwMFTRecordSz, m_bytesPerCluster);
 	nRet = mftRecord.ExtractStream(mftBlock, pStreamFilter);
 	if (nRet)
 		return nRet;
+    if (mftRecord.m_hasAttrList)
+        mftRecord.MergeExtensions(m_entries, mftIndex);
 
 	// Store the file details in stFileInfo, extracting the info from the MFT.
     stFileInfo.filename = std::wstring(mftRecord.m_attrFilename.wFilename, mftRecord.m_attrFilename.chFileNameLength);
@@ -1080,7 +1826,19 @@ int NtfsUtil::GetSelectedFile(
     stFileInfo.parentSeq = (DWORD)mftRecord.m_attrFilename.dwMftParentDir;
 
     stFileInfo.nameCnt   = mftRecord.m_nameCnt;
+    stFileInfo.hardLinks = mftRecord.m_hardLinks;
+    stFileInfo.frag      = mftRecord.m_frag;
     stFileInfo.streamCnt = mftRecord.m_streamCnt;
+
+    // Which arguments sharing this scan want the file, directories are checked when reported.
+    stFileInfo.targetMask = 0;
+    for (unsigned targetIdx = 0; m_pTargets != NULL && targetIdx < m_pTargets->size(); targetIdx++)
+    {
+        const FsFilter& nameFilter = *(*m_pTargets)[targetIdx].nameFilter;
+        if (!nameFilter.IsValid() 
+            || nameFilter.IsMatch(mftRecord.m_attrStandard, mftRecord.m_attrFilename, MatchInfo(&mftRecord)))
+            stFileInfo.targetMask |= 1ULL << targetIdx;
+    }
     stFileInfo.m_fileOnDisk.swap(mftRecord.m_fileOnDisk);
 
     if (getDir && mftRecord.m_attrFilename.dwMftParentDir != 0)
@@ -1096,65 +1854,178 @@ int NtfsUtil::GetSelectedFile(
 }
 
 // ------------------------------------------------------------------------------------------------
-int NtfsUtil::GetDirectory(std::wstring& directory, LONGLONG mftIndex)  
+// Return file details of entry collected while filtering, same as GetFileInfo without
+// parsing the record again. Return 0 on success.
+int NtfsUtil::GetEntryInfo(const MFTEntryList& entryList, size_t entryIdx, FileInfo& stFileInfo)
+{
+    const FileCatalog& catalog = entryList.entries;
+    stFileInfo.filename.assign(entryList.names.data() + catalog.m_nameOffset[entryIdx], catalog.m_nameLen[entryIdx]);
+    stFileInfo.dwAttributes = catalog.m_attributes[entryIdx];
+    stFileInfo.n64Create = catalog.m_create[entryIdx];
+    stFileInfo.n64Modify = catalog.m_modify[entryIdx];
+    stFileInfo.n64Access = catalog.m_access[entryIdx];
+    stFileInfo.n64Modfil = catalog.m_modfil[entryIdx];
+    stFileInfo.diskSize  = catalog.m_diskSize[entryIdx];
+    stFileInfo.fileSize  = catalog.m_fileSize[entryIdx];
+    stFileInfo.bDeleted  = (catalog.m_state[entryIdx] & FileCatalog::sInUse) == 0;
+    stFileInfo.bSparse   = (catalog.m_state[entryIdx] & FileCatalog::sSparse) != 0;
+    stFileInfo.parentSeq = (DWORD)catalog.m_parentRef[entryIdx];
+    stFileInfo.nameCnt   = catalog.m_nameCnt[entryIdx];
+    stFileInfo.hardLinks = catalog.m_hardLinks[entryIdx];
+    stFileInfo.frag      = catalog.m_frag[entryIdx];
+    stFileInfo.streamCnt = catalog.m_streamCnt[entryIdx];
+    stFileInfo.targetMask = catalog.m_targetMask[entryIdx];
+    stFileInfo.m_fileOnDisk.clear();
+    stFileInfo.directory.clear();
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Name filter of each target, see ReportCfg::targets.
+MFTRecord::FilterList NtfsUtil::TargetFilters() const
+{
+    MFTRecord::FilterList filters;
+    for (unsigned targetIdx = 0; m_pTargets != NULL && targetIdx < m_pTargets->size(); targetIdx++)
+        filters.push_back((*m_pTargets)[targetIdx].nameFilter);
+    return filters;
+}
+
+// ------------------------------------------------------------------------------------------------
+void NtfsUtil::FixupRecords(BYTE* pData, size_t len) const
+{
+    RecordFixup fixup(m_dwMFTRecordSz, m_sectorSize);
+    fixup.Apply(pData, len);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Read directory records missing from m_dirTable, then their parents, level by level, so 
+// each level is read with several reads in flight rather than one record at a time.
+// Records which can not be read are left for GetDirectory to retry.
+// Return 0 on success, else last error.
+int NtfsUtil::PrefetchDirectories(std::vector<DWORD>& mftIndexes)
 {
-    DirMap::const_iterator dirIter = m_dirMap.find(mftIndex);
-    if (dirIter != m_dirMap.end())
+    const DWORD sMaxDirGap = 64 << 10;      // Read over small holes between directory records.
+    LONGLONG n64StartPos = (LONGLONG)m_startSector * m_bytesPerSector;
+
+    Buffer records;
+    std::vector<DWORD> parents;
+    while (!mftIndexes.empty())
     {
-        directory = dirIter->second;
-        return ERROR_SUCCESS;
-    }
+        std::sort(mftIndexes.begin(), mftIndexes.end());
+        mftIndexes.erase(std::unique(mftIndexes.begin(), mftIndexes.end()), mftIndexes.end());
 
-    LONGLONG n64LCN, n64Len = m_dwMFTRecordSz;
-    if (!GetDiskPosition(mftIndex * m_dwMFTRecordSz / m_bytesPerCluster, n64LCN, n64Len))
-        return ReturnError(ERROR_INVALID_BLOCK);
+        ReadPlan::ExtentList extents;
+        std::vector<DWORD> readIndexes;
+        for (unsigned idx = 0; idx < mftIndexes.size(); idx++)
+        {
+            LONGLONG byteOffset = (LONGLONG)mftIndexes[idx] * m_dwMFTRecordSz;
+            if (m_dirTable.Has(mftIndexes[idx]) || !GetDiskExtents(byteOffset, m_dwMFTRecordSz, extents))
+                continue;
+            readIndexes.push_back(mftIndexes[idx]);
+        }
 
-    unsigned MFTperCluster = m_bytesPerCluster / m_dwMFTRecordSz;
-    unsigned bufferIdx = mftIndex % MFTperCluster;
+        records.clear();
+        int nRet = ReadPlan::ReadAll(*m_reader, extents, records, m_loadConfig.maxRequest, sMaxDirGap, m_loadConfig.queueDepth);
+        if (nRet)
+            return nRet;
 
-    MFTRecord mftRecord;
-	mftRecord.SetDriveHandle(m_hDrive);
-	mftRecord.SetRecordInfo((LONGLONG)m_startSector * m_bytesPerSector, m_dwMFTRecordSz, m_bytesPerCluster);
+        FixupRecords(records.Data(), records.size());
+        parents.clear();
+        for (unsigned idx = 0; idx < readIndexes.size(); idx++)
+        {
+            MFTRecord mftRecord;
+            mftRecord.SetReader(m_reader);
+            mftRecord.SetRecordInfo(n64StartPos, m_dwMFTRecordSz, m_bytesPerCluster);
+            Buffer fileBuf = records.Region(idx * m_dwMFTRecordSz, m_dwMFTRecordSz);
+            if (mftRecord.ExtractFile(fileBuf, false) != ERROR_SUCCESS)
+                continue;
 
-    Buffer buffer;
-    mftRecord.ReadRaw(n64LCN, buffer, m_bytesPerCluster);
-    Buffer fileBuf = buffer.Region(bufferIdx * m_dwMFTRecordSz, m_dwMFTRecordSz);
-    
-	int nRet = mftRecord.ExtractFile(fileBuf, false);
-	if (nRet)
-		return nRet;
-   
-    LONGLONG parentIdx = mftRecord.m_attrFilename.dwMftParentDir & sParentMask;
-    if (parentIdx != mftIndex)
+            // Record without a name is treated as root to end the search.
+            DWORD parentIdx = (DWORD)(mftRecord.m_attrFilename.dwMftParentDir & sParentMask);
+            if (mftRecord.m_attrFilename.chFileNameLength == 0)
+                parentIdx = readIndexes[idx];
+            m_dirTable.Add(readIndexes[idx], parentIdx, mftRecord.m_attrFilename.wFilename, mftRecord.m_attrFilename.chFileNameLength);
+            if (!m_dirTable.Has(parentIdx))
+                parents.push_back(parentIdx);
+        }
+        mftIndexes.swap(parents);
+    }
+
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Build directory from m_dirTable, directories not loaded or streamed yet are read from disk.
+int NtfsUtil::GetDirectory(std::wstring& directory, LONGLONG mftIndex)
+{
+    DWORD missing;
+    while (!m_dirTable.GetPath((DWORD)mftIndex, m_slash, directory, missing))
     {
-        nRet = GetDirectory(directory, parentIdx);
-        directory += m_slash;
-        directory += std::wstring(mftRecord.m_attrFilename.wFilename, mftRecord.m_attrFilename.chFileNameLength);
+        MFTRecord mftRecord;
+        int nRet = ReadMFTRecord(missing, mftRecord);
+        if (nRet)
+            return nRet;
+
+        // Record without a name is treated as root to end the search.
+        DWORD parentIdx = (DWORD)(mftRecord.m_attrFilename.dwMftParentDir & sParentMask);
+        if (mftRecord.m_attrFilename.chFileNameLength == 0)
+            parentIdx = missing;
+        m_dirTable.Add(missing, parentIdx, mftRecord.m_attrFilename.wFilename, mftRecord.m_attrFilename.chFileNameLength);
+        if (!m_dirTable.Has(missing))
+            return ReturnError(ERROR_INVALID_DATA);     // Past the MFT, see DirTable::SetLimit.
     }
-    else
-        directory.clear();
-    
-    m_dirMap[mftIndex] = directory;
 	return ERROR_SUCCESS;
 }
 
 // ------------------------------------------------------------------------------------------------
-int NtfsUtil::GetDiskPosition(LONGLONG findLCN, LONGLONG& outLCN, LONGLONG& inOutLen)  
+// Read and parse one MFT record from disk.
+int NtfsUtil::ReadMFTRecord(LONGLONG mftIndex, MFTRecord& mftRecord)
+{
+    // Record is part of a cluster, or spans several (4 KB records on small clusters) which
+    // may lie in different data runs.
+    ReadPlan::ExtentList extents;
+    if (!GetDiskExtents(mftIndex * m_dwMFTRecordSz, m_dwMFTRecordSz, extents))
+        return ReturnError(ERROR_INVALID_BLOCK);
+
+	mftRecord.SetReader(m_reader);
+	mftRecord.SetRecordInfo((LONGLONG)m_startSector * m_bytesPerSector, m_dwMFTRecordSz, m_bytesPerCluster);
+
+    Buffer fileBuf;
+    int nRet = ReadPlan::ReadAll(*m_reader, extents, fileBuf, m_loadConfig.maxRequest, 0);
+    if (nRet)
+        return nRet;
+    FixupRecords(fileBuf.Data(), fileBuf.size());
+
+	return mftRecord.ExtractFile(fileBuf, false);
+}
+
+// ------------------------------------------------------------------------------------------------
+bool NtfsUtil::GetDiskExtents(LONGLONG byteOffset, DWORD len, ReadPlan::ExtentList& extents) const
 {
-    LONGLONG inLCNLen = inOutLen / m_bytesPerCluster;
-    LONGLONG offLCN = 0;
-    for (unsigned idx = 0; idx != m_fileOnDisk.size(); idx++)
+    LONGLONG n64StartPos = (LONGLONG)m_startSector * m_bytesPerSector;
+    size_t firstExtent = extents.size();
+    LONGLONG runOff = 0;        // MFT byte offset at start of run.
+    for (unsigned idx = 0; idx != m_fileOnDisk.size() && len != 0; idx++)
     {
-        if (findLCN >= offLCN && findLCN + inLCNLen <= offLCN + m_fileOnDisk[idx].second / m_bytesPerCluster)
+        LONGLONG runLen = m_fileOnDisk[idx].second;
+        if (byteOffset < runOff + runLen)
         {
-            outLCN = m_fileOnDisk[idx].first + (findLCN - offLCN);
-            return true;
+            ReadPlan::Extent extent;
+            extent.pos = n64StartPos + m_fileOnDisk[idx].first * m_bytesPerCluster + (byteOffset - runOff);
+            extent.len = (DWORD)min((LONGLONG)len, runOff + runLen - byteOffset);
+            extents.push_back(extent);
+            byteOffset += extent.len;
+            len -= extent.len;
         }
-
-        offLCN += m_fileOnDisk[idx].second / m_bytesPerCluster;
+        runOff += runLen;
     }
 
-    return false;
+    if (len != 0)
+    {
+        extents.resize(firstExtent);
+        return false;
+    }
+    return true;
 }
 
 
@@ -1168,9 +2039,9 @@ int NtfsUtil::GetDiskPosition(LONGLONG findLCN, LONGLONG& outLCN, LONGLONG& inOu
     const MFTRecord* pMFTRecord = (const MFTRecord*)matchInfo.pMFTRecord;
     bool inUse = pMFTRecord->m_bInUse;
     if (inUse)
-        m_activeInfo.Count(fileInfo);
+        m_activeInfo.Count(fileInfo, *pMFTRecord);
     else
-        m_deletedInfo.Count(fileInfo);
+        m_deletedInfo.Count(fileInfo, *pMFTRecord);
 
 #ifdef DUMP_DETAIL_MFT
     return true;    // keep all files.
@@ -1188,13 +2059,15 @@ int NtfsUtil::GetDiskPosition(LONGLONG findLCN, LONGLONG& outLCN, LONGLONG& inOu
 
 // ------------------------------------------------------------------------------------------------
 
-void CountFilter::CountInfo::Count(const MFT_FILEINFO& name) 
+// Record counted once using its preferred name, name types counted for every name.
+void CountFilter::CountInfo::Count(const MFT_FILEINFO& name, const MFTRecord& mftRecord) 
 {
     bool isDir  = (name.dwFlags & eDirectory) == eDirectory;
     unsigned attrIdx = (name.dwFlags & 7);  // 1=Ronly, 2=hidden, 4=System
        
     m_attrCnt[attrIdx]++;
-    m_nameTypeCnt[name.chFileNameType & 3]++;
+    for (unsigned nameIdx = 0; nameIdx < mftRecord.m_names.size(); nameIdx++)
+        m_nameTypeCnt[mftRecord.m_names[nameIdx].nameType & 3]++;
 
     if (isDir)
         m_dirCnt++;
@@ -1,4 +1,4 @@
-// ------------------------------------------------------------------------------------------------
+﻿// ------------------------------------------------------------------------------------------------
 // Class to read NTFS Master File Table and scan for matching files.
 //
 // Original code from T.YogaRamanan's Undelete project posted to CodeProject 13-Jan-2005.
@@ -35,12 +35,17 @@
 #pragma once
 
 #include "BaseTypes.h"
+#include "DirTable.h"
 #include "FsUtil.h"
 #include "MFTRecord.h"
 #include "FsFilter.h"
+#include "MFTLoader.h"
+#include "MFTSnapshot.h"
+#include "VolumeReader.h"
 
 #include <string>
 #include <stack>
+#include <sstream>
 
 
 // ------------------------------------------------------------------------------------------------
@@ -60,8 +65,12 @@ public:
             , diskSize(false), fileSize(false)
             , attribute(false), directory(true), name(true)
             , nameCnt(false), streamCnt(false), showVcn(false), 
+            fragInfo(false), mostFragmented(0),
 
             showDetail(false), deleted(false),
+            loadThreads(MFTLoader::DefaultWorkers()), loadStats(false), skipFree(true),
+            memoryLimitMB(0), readRequestKB(0), queueDepth(0), benchmark(false), directIO(false),
+            sequential(false), snapshotDir(NULL), refreshSnapshot(false), snapshotMaxAge(300),
 
             attributes((DWORD)-1),
             slash('\\'), separator(L" "), volume(L""),
@@ -82,13 +91,28 @@ public:
         bool        directoryFilter;   // load directory so it can filtered.
         bool        name;
 
-        bool        nameCnt;           // include #names associated with file
+        bool        nameCnt;           // include #names and #hard links associated with file
         bool        streamCnt;         // include #streams associated with file.
         bool        showVcn;           // show VCN array StartVcn#Vcn...
+        bool        fragInfo;          // include #fragments, #sparse runs and largest gap.
+        DWORD       mostFragmented;    // Only report this many most fragmented files, 0 = all.
 
         bool        showDetail;        // When in 'Q' mode show all MFT record details.
         bool        deleted;           // Must be deleted 
 
+        unsigned    loadThreads;       // MFT parse/filter threads, 0 = no read ahead.
+        bool        loadStats;         // Show MFT load timing on stderr.
+        bool        skipFree;          // Do not read free MFT records, ignored for deleted scans.
+        DWORD       memoryLimitMB;     // Stream MFT in chunks using about this much memory, 0 = load all.
+        DWORD       readRequestKB;     // Largest merged MFT read, 0 = default.
+        unsigned    queueDepth;        // Volume reads in flight, 0 = default.
+        bool        benchmark;         // Only report read throughput at several queue depths.
+        bool        directIO;          // Unbuffered reads, do not fill the system file cache.
+        bool        sequential;        // Reader is forward only, see SequentialReader.
+        const wchar_t* snapshotDir;    // Directory of MFT snapshot files, NULL = no snapshot.
+        bool        refreshSnapshot;   // Rebuild MFT snapshot even if it matches volume.
+        DWORD       snapshotMaxAge;    // Seconds MFT snapshot is reused, later changes are not seen.
+
         DWORD       attributes;        // Limit output to items with these attributes
 
         // Global values.
@@ -99,6 +123,18 @@ public:
         SharePtr<FsFilter> readFilter; // Filter while reading MFT.
         SharePtr<FsFilter> postFilter; // Filter while presenting results (directory filter).
 
+        // Several path arguments on one volume (ex: c:\foo\*.txt c:\bar\*.log) share one 
+        // MFT load, each file is reported under every target it matches, grouped by target.
+        // readFilter must pass any target's files. Empty for a single argument.
+        struct Target
+        {
+            std::wstring        label;      // Argument, ex: c:\foo\*.txt
+            SharePtr<FsFilter>  nameFilter; // Tested on MFT record, empty list = any name.
+            SharePtr<FsFilter>  dirFilter;  // Tested on directory, empty list = any directory.
+        };
+        static const unsigned sMaxTargets = 64;     // Bits in FileInfo::targetMask.
+        std::vector<Target> targets;
+
         std::stack<SharePtr<FsFilter>> stackFilter;
         void PushFilter()
         {
@@ -153,19 +189,27 @@ public:
         std::wstring directory;
 
         DWORD        nameCnt;       // number of names associated with this file (DOS, unicode, etc)
+        DWORD        hardLinks;     // number of hard links, from MFT record header.
         DWORD        streamCnt;     // number of alternate data streams.
+        FragInfo     frag;          // Fragmentation of data streams.
+        ULONGLONG    targetMask;    // Bit per ReportCfg::targets entry whose nameFilter matched.
 
         // Start VCN and #of VCN per fragment.
         typedef std::vector<std::pair<LONGLONG,LONGLONG>> FileOnDiskList;
         FileOnDiskList  m_fileOnDisk;
 	};
 
-    // Filter selection, return 0 on success, else last error.
-    int GetSelectedFile(DWORD nFileSeq, const SharePtr<FsFilter>& filter, FileInfo& fileInfo, 
-        bool dir=false, StreamFilter* pStreamFilter=NULL);
+    // Return file details of MFT record at mftIndex, return 0 on success, else last error.
+    int GetFileInfo(const Block& mftBlock, DWORD mftIndex, FileInfo& fileInfo, bool dir=false, StreamFilter* pStreamFilter=NULL);
+
+    // Return file details of entry collected while loading, see MFTLoader::Load.
+    static int GetEntryInfo(const MFTEntryList& entryList, size_t entryIdx, FileInfo& fileInfo);
 
     int GetDirectory(std::wstring& directory, LONGLONG mftIndex);
-    int GetDiskPosition(LONGLONG findLCN, LONGLONG& n64LCN, LONGLONG& n64Len); 
+
+    // Append disk extents of len bytes at MFT byteOffset, a record may span data runs.
+    // Return false if the MFT is shorter.
+    bool GetDiskExtents(LONGLONG byteOffset, DWORD len, ReadPlan::ExtentList& extents) const;
 
 #if 0
     // Return details on file entry.
@@ -175,13 +219,16 @@ public:
 	int Read_File(DWORD nFileSeq, Buffer& outFileData);
 #endif
 
-protected:
-	void SetDriveHandle(HANDLE hDrive)
+    // Optionally set source of volume data (ex: image file) before calling ScanFiles or QueryMFT.
+    // If not set, ScanFiles opens the volume.
+	void SetReader(const SharePtr<VolumeReader>& reader)
     {
-	    m_hDrive = hDrive;
+	    m_reader = reader;
 	    m_bInitialized = false;
     }
 
+protected:
+
 	void SetStartSector(DWORD dwStartSector, DWORD dwBytesPerSector);
   
     // Return 0 on success, else last error
@@ -191,22 +238,103 @@ protected:
     // Load MFT into memory, removing item which fail filter test.
 	int LoadMFT(LONGLONG nStartCluster, const FsFilter& filter);
 
+    // Load catalog from MFT snapshot file if it matches volume and is recent, else rebuild it.
+    // Return 0 on success, else last error (caller reads volume instead).
+    int LoadSnapshot(const Buffer& mftHeader, const MFTRecord::FileOnDiskList& runs, const FsFilter& filter);
+
+    // Append $MFT data runs held in extension records, return 0 on success, else last error.
+    int AddMFTExtensionRuns(MFTRecord& mftRecord);
+
+    // Load MFT with loader into m_entries, or m_copyOfMFT if m_keepRecords.
+    // Return 0 on success, else last error.
+    int LoadRecords(MFTLoader& loader, const MFTRecord::FileOnDiskList& runs, const FsFilter& filter);
+
+    // Read $MFT:$BITMAP, return 0 on success, else last error.
+    int LoadMFTBitmap(const Buffer& mftHeader, Buffer& bitmap);
+
+    int CheckMFTName(const MFTRecord& mftRecord);
+
+    void ShowLoadStats(std::wostream& wout) const;
+
+    // Scan MFT chunk by chunk, see ReportCfg::memoryLimitMB.
+    class StreamSink;
+    DWORD StreamFiles(const ReportCfg& reportCfg, std::wostream& wout, StreamFilter* pStreamFilter);
+
+    static std::wstring MakeHeading(const ReportCfg& reportCfg);
+    static bool IsDirectoryMatch(const FsFilter& dirFilter, const FileInfo& fileInfo);
+    void ReportFile(const FileInfo& fileInfo, const ReportCfg& reportCfg, std::wostream& wout, 
+        const std::wstring& heading, bool& drawHeader);
+    void ReportFiles(std::vector<FileInfo>& files, const ReportCfg& reportCfg, std::wostream& wout, 
+        const std::wstring& heading, bool& drawHeader);
+    void OutputFiles(std::vector<FileInfo>& files, const ReportCfg& reportCfg, std::wostream& wout, 
+        const std::wstring& heading, bool& drawHeader);
+
+    // See ReportCfg::mostFragmented, files are held until the scan completes.
+    void KeepMostFragmented(const std::vector<FileInfo>& files, const ReportCfg& reportCfg);
+    void ReportMostFragmented(const ReportCfg& reportCfg, std::wostream& wout, 
+        const std::wstring& heading, bool& drawHeader);
+
+    // Select, sort and report files of the catalog collected while filtering.
+    DWORD ScanCatalog(const ReportCfg& reportCfg, std::wostream& wout, 
+        const std::wstring& heading, bool& drawHeader, DWORD maxFiles, StreamFilter* pStreamFilter);
+    int ReadDataRuns(const std::vector<DWORD>& mftIndexes, std::vector<FileInfo>& files, StreamFilter* pStreamFilter);
+
+    // Write output of targets after the first, held until the scan completes.
+    void FlushTargets(std::wostream& wout);
+
+    // Name filter of each target, used to fill MFTEntry::targetMask while loading.
+    MFTRecord::FilterList TargetFilters() const;
+
+    // Report volume read throughput at queue depth 1, 4, 16 and 64.
+    DWORD BenchmarkReads(const ReportCfg& reportCfg, std::wostream& wout);
+
+    int PrefetchDirectories(std::vector<DWORD>& mftIndexes);
+    int ReadMFTRecord(LONGLONG mftIndex, MFTRecord& mftRecord);
+
+    // Apply fixups to records just read from the volume, see RecordFixup.
+    void FixupRecords(BYTE* pData, size_t len) const;
+
     // Global objects.
     DWORD   m_error;
     bool    m_abort;
     wchar_t m_slash;                // used to build directory path.
 
     // Physical drive info 
-	Hnd	    m_hDrive;
+	SharePtr<VolumeReader> m_reader;
 	bool    m_bInitialized;
 	DWORD   m_startSector;          // Starting location of MFT
 	DWORD   m_bytesPerCluster;      // = bytersPerSector * sectorsPerCluster
 	DWORD   m_bytesPerSector;
+    DWORD   m_sectorSize;           // From boot sector, checked against record fixup stride.
  
     // MFT info  
-	Buffer      m_copyOfMFT;        // In memory copy of MFT, optionally trimmed by filter.
+	Buffer      m_copyOfMFT;        // In memory copy of MFT trimmed by filter, only if m_keepRecords.
+    MFTEntryList m_entries;         // Catalog of files which passed filter, scans report from it.
     Buffer      m_oneMFTRecord;     // Helper to walk MFT on record at a time.
 	DWORD       m_dwMFTRecordSz;    // MFT record size
+    DWORD       m_mftRecords;       // Records in $MFT:$DATA, every MFT index is below.
+
+    MFTLoader::Config m_loadConfig;
+    MFTLoader::Stats  m_loadStats;
+    bool        m_skipFree;         // Skip free records using $MFT:$BITMAP.
+    BYTE        m_select;           // RecordClass bits a scan parses, see RecordClass.
+    bool        m_keepRecords;      // Query (-Q) keeps the records, scans only m_entries.
+    Buffer      m_mftBitmap;        // $MFT:$BITMAP, empty if not used.
+    bool        m_streaming;        // MFT is not kept in memory, see StreamFiles.
+    bool        m_retainMFT;        // Forward only reader keeps MFT, records are read again (-V).
+
+    std::wstring m_snapshotDir;     // Empty if snapshot is not used.
+    bool        m_refreshSnapshot;
+    DWORD       m_snapshotMaxAge;   // Seconds, see ReportCfg::snapshotMaxAge.
+    bool        m_fromSnapshot;     // Catalog was loaded from snapshot.
+    LONGLONG    m_volumeSerial;     // Boot sector serial number.
+
+    // See ReportCfg::targets, first target is written directly to output.
+    const std::vector<ReportCfg::Target>* m_pTargets;
+    std::vector<SharePtr<std::wostringstream>> m_targetOut;
+    std::vector<bool> m_targetHeader;   // Heading not yet drawn.
+
+    std::vector<FileInfo> m_mostFragmented;   // See ReportCfg::mostFragmented.
 
     // Copy of MFT header record.
     MFT_FILE_HEADER m_NtfsMFT;
@@ -214,9 +342,9 @@ protected:
     // Remember on disk lcn and chuck sizes.
     MFTRecord::FileOnDiskList m_fileOnDisk;
 
-    // Remember previous fetched directory to mftIndex mappings.
-    typedef std::map<LONGLONG, std::wstring> DirMap;
-    DirMap m_dirMap;
+    // Directory parent and name, filled while loading or streaming, directories missing
+    // from the loaded MFT (deleted) are added by PrefetchDirectories.
+    DirTable m_dirTable;
 
     MFTRecord::TypeCnt m_typeCnt;
 };
@@ -238,6 +366,10 @@ public:
     virtual bool IsValid() const
     { return true; }
 
+    // Counters are not guarded.
+    virtual bool IsThreadSafe() const
+    { return false; }
+
     struct CountInfo
     {
         CountInfo() :
@@ -248,7 +380,7 @@ public:
             ZeroMemory(m_nameTypeCnt, sizeof(m_nameTypeCnt));
         }
 
-        void Count(const MFT_FILEINFO& name);
+        void Count(const MFT_FILEINFO& name, const MFTRecord& mftRecord);
 
         DWORD       m_attrCnt[15];          // 1=Ronly, 2=hidden, 4=System
         DWORD       m_fileCnt;
@@ -293,6 +425,8 @@ public:
 
     virtual bool IsMatch(const MFT_STANDARD &, const MFT_FILEINFO&, const MatchInfo& matchInfo) const
     {
+        if (matchInfo.pCatalog != NULL)
+            return m_test(((const FileCatalog*)matchInfo.pCatalog)->m_streamCnt[matchInfo.row], m_size) == m_matchOn;
         const MFTRecord* pMFTRecord = (const MFTRecord*)matchInfo.pMFTRecord;
         return m_test(pMFTRecord->m_streamCnt, m_size) == m_matchOn;
     }
@@ -302,6 +436,33 @@ public:
 };
 
 
+// ------------------------------------------------------------------------------------------------
+// Custom Match filter to test against fragment count of data streams.
+// ------------------------------------------------------------------------------------------------
+
+class FragCntMatch : public Match
+{
+public:
+    typedef bool (*Test)(size_t inSize, size_t matchSize);
+
+    FragCntMatch(size_t size, Test test = IsCntGreater, bool matchOn = true) :
+        Match(matchOn),
+        m_size(size), m_test(test) 
+    { }
+
+    virtual bool IsMatch(const MFT_STANDARD &, const MFT_FILEINFO&, const MatchInfo& matchInfo) const
+    {
+        if (matchInfo.pCatalog != NULL)
+            return m_test(((const FileCatalog*)matchInfo.pCatalog)->m_frag[matchInfo.row].fragments, m_size) == m_matchOn;
+        const MFTRecord* pMFTRecord = (const MFTRecord*)matchInfo.pMFTRecord;
+        return m_test(pMFTRecord->m_frag.fragments, m_size) == m_matchOn;
+    }
+
+    size_t      m_size;
+    Test        m_test;
+};
+
+
 // ------------------------------------------------------------------------------------------------
 // Custom match filter to match on directory name.
 // ------------------------------------------------------------------------------------------------
@@ -0,0 +1,93 @@
+// ------------------------------------------------------------------------------------------------
+// Classify MFT record slots from their header, select the records a scan needs.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "RecordClass.h"
+#include "NtfsTypes.h"
+
+#include <stddef.h>
+#include <string.h>
+
+static const DWORD sFlagsOffset = offsetof(MFT_FILE_HEADER, wFlags);
+
+// Class of a "FILE" record indexed by flag bits [inUse][isDir].
+static const BYTE sFileClass[4] = 
+{
+    RecordClass::sFree, RecordClass::sFree, RecordClass::sInUse, RecordClass::sInUseDir
+};
+
+// ------------------------------------------------------------------------------------------------
+static inline DWORD Load32(const BYTE* pData)
+{
+    DWORD value;
+    memcpy(&value, pData, sizeof(value));
+    return value;
+}
+
+// ------------------------------------------------------------------------------------------------
+static inline BYTE MakeClass(bool isFile, bool isBaad, bool isZero, WORD flags)
+{
+    if (isFile)
+        return sFileClass[((flags & 0x01) << 1) | ((flags & 0x02) >> 1)];
+    return isBaad ? RecordClass::sBaad : (isZero ? RecordClass::sZero : RecordClass::sBadSig);
+}
+
+// ------------------------------------------------------------------------------------------------
+BYTE RecordClass::ClassOf(const BYTE* pRecord)
+{
+    DWORD sig = Load32(pRecord);
+    WORD flags = *(const WORD*)(pRecord + sFlagsOffset);
+    return MakeClass(sig == Load32((const BYTE*)"FILE"), sig == Load32((const BYTE*)"BAAD"), sig == 0, flags);
+}
+
+// ------------------------------------------------------------------------------------------------
+void RecordClass::Classify(const BYTE* pData, DWORD recCnt, DWORD recSize, BYTE* pClass)
+{
+    for (DWORD recIdx = 0; recIdx < recCnt; recIdx++)
+        pClass[recIdx] = ClassOf(pData + (size_t)recIdx * recSize);
+}
+
+// ------------------------------------------------------------------------------------------------
+void RecordClass::Select(const BYTE* pData, DWORD recCnt, DWORD recSize, BYTE want, Selection& selection)
+{
+    selection.clear();
+
+    const DWORD sBlock = 256;
+    BYTE classes[sBlock];
+    for (DWORD first = 0; first < recCnt; first += sBlock)
+    {
+        DWORD cnt = min(recCnt - first, sBlock);
+        Classify(pData + (size_t)first * recSize, cnt, recSize, classes);
+        for (DWORD idx = 0; idx < cnt; idx++)
+        {
+            if ((classes[idx] & want) != 0)
+                selection.push_back(first + idx);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+// ------------------------------------------------------------------------------------------------
+// Classify MFT record slots from their header, select the records a scan needs.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Classify each record slot of a chunk of MFT from its signature and flags only, before any
+// attribute is parsed, and list the slots a scan needs. Only the signature and flags of each
+// slot are read. Slots are a record apart, so their headers are loaded one at a time, SIMD
+// compares would first have to gather them and gain nothing. Flags lie in the first sector
+// ahead of its fixup, so raw and fixed records give the same class (torn records are only
+// "BAAD" once fixups are applied).
+//
+//  Ex:
+//      RecordClass::Selection selection;
+//      RecordClass::Select(pData, recCnt, 1024, RecordClass::sInUse | RecordClass::sInUseDir, selection);
+//      for (unsigned selIdx = 0; selIdx < selection.size(); selIdx++)
+//          ... parse record selection[selIdx]
+
+class RecordClass
+{
+public:
+    // Class of a slot, one bit each so a scan can want several.
+    static const BYTE sInUse    = 0x01;     // "FILE", in use, not a directory.
+    static const BYTE sInUseDir = 0x02;     // "FILE", in use directory.
+    static const BYTE sFree     = 0x04;     // "FILE", not in use (deleted file or directory).
+    static const BYTE sZero     = 0x08;     // Zeroed slack, never written.
+    static const BYTE sBaad     = 0x10;     // "BAAD", see RecordFixup.
+    static const BYTE sBadSig   = 0x20;     // Any other signature.
+    static const BYTE sAnyFile  = sInUse | sInUseDir | sFree;
+
+    typedef std::vector<DWORD> Selection;   // Record index in chunk, ascending.
+
+    // Set class of recCnt records into pClass.
+    static void Classify(const BYTE* pData, DWORD recCnt, DWORD recSize, BYTE* pClass);
+
+    // Set selection to index of records whose class is one of 'want'.
+    static void Select(const BYTE* pData, DWORD recCnt, DWORD recSize, BYTE want, Selection& selection);
+
+    // Class of one record.
+    static BYTE ClassOf(const BYTE* pRecord);
+};
@@ -0,0 +1,176 @@
+// ------------------------------------------------------------------------------------------------
+// MFT record update sequence (fixup) check and repair, applied once after each read.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "RecordFixup.h"
+#include "NtfsTypes.h"
+
+static const char sFileSig[4] = { 'F', 'I', 'L', 'E' };
+static const char sBaadSig[4] = { 'B', 'A', 'A', 'D' };
+
+// ------------------------------------------------------------------------------------------------
+static inline DWORD Load32(const void* pData)
+{
+    DWORD value;
+    memcpy(&value, pData, sizeof(value));
+    return value;
+}
+
+// ------------------------------------------------------------------------------------------------
+void RecordFixup::Apply(BYTE* pData, size_t len)
+{
+    switch (m_recSize)
+    {
+    case 1024:
+        ApplyAll<1024>(pData, len);
+        break;
+    case 4096:
+        ApplyAll<4096>(pData, len);
+        break;
+    default:
+        ApplyAll<0>(pData, len);
+        break;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+template <DWORD RecSize> 
+void RecordFixup::ApplyAll(BYTE* pData, size_t len)
+{
+    // Signatures are a record apart, each is one 32 bit compare. Vector compares would have
+    // to gather them first, see RecordClass.
+    const DWORD recSize = (RecSize != 0) ? RecSize : m_recSize;
+    const DWORD fileSig = Load32(sFileSig);
+    const DWORD baadSig = Load32(sBaadSig);
+    for (size_t off = 0; off + recSize <= len; off += recSize)
+    {
+        BYTE* pRecord = pData + off;
+        DWORD sig = Load32(pRecord);
+        if (sig == fileSig)
+        {
+            m_counts.records++;
+            ApplyRecord<RecSize>(pRecord);
+        }
+        else if (sig == baadSig)
+        {
+            m_counts.records++;
+            m_counts.bad++;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Stride of update sequence array with usaCount entries (USN + one per sector), 0 if invalid.
+template <DWORD RecSize> 
+DWORD RecordFixup::Stride(DWORD usaCount) const
+{
+    const DWORD recSize = (RecSize != 0) ? RecSize : m_recSize;
+    if (usaCount < 2)
+        return 0;
+    DWORD sectors = usaCount - 1;
+    DWORD stride = recSize / sectors;
+    if (stride * sectors != recSize)
+        return 0;
+    return (stride == sMinStride || stride == m_bytesPerSector) ? stride : 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Check all sector ends hold usn before changing any, then restore them from the array.
+// Sectors and Stride are 0 for any record size, else constants so the loops unroll.
+// Return false if torn.
+template <DWORD Sectors, DWORD Stride>
+static bool FixSectors(BYTE* pRecord, const WORD* pUsa, DWORD sectors, DWORD stride)
+{
+    if (Sectors != 0)
+    {
+        sectors = Sectors;
+        stride = Stride;
+    }
+
+    const WORD usn = pUsa[0];
+    bool torn = false;
+    for (DWORD idx = 0; idx < sectors; idx++)
+        torn |= (*(const WORD*)(pRecord + (idx + 1) * stride - sizeof(WORD)) != usn);
+    if (torn)
+        return false;
+
+    for (DWORD idx = 0; idx < sectors; idx++)
+        *(WORD*)(pRecord + (idx + 1) * stride - sizeof(WORD)) = pUsa[idx + 1];
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+template <DWORD RecSize> 
+bool RecordFixup::ApplyRecord(BYTE* pRecord)
+{
+    MFT_FILE_HEADER* pHeader = (MFT_FILE_HEADER*)pRecord;
+    DWORD usaOffset = pHeader->wFixupOffset;
+    DWORD usaCount = pHeader->wFixupSize;
+    DWORD stride = Stride<RecSize>(usaCount);
+
+    // Array must lie in the first sector, ahead of its last WORD.
+    if (stride == 0 || (usaOffset & 1) != 0 || usaOffset + usaCount * sizeof(WORD) > stride - sizeof(WORD))
+    {
+        memcpy(pRecord, sBaadSig, 4);
+        m_counts.bad++;
+        return false;
+    }
+
+    // Stride checked that usaCount - 1 == recSize / stride, so a 1 KB or 4 KB record with a
+    // sector size stride has a constant sector count.
+    const WORD* pUsa = (const WORD*)(pRecord + usaOffset);
+    DWORD sectors = usaCount - 1;
+    bool whole;
+    switch ((RecSize != 0) ? stride : 0)
+    {
+    case 512:
+        whole = FixSectors<RecSize / 512, 512>(pRecord, pUsa, sectors, stride);
+        break;
+    case 1024:
+        whole = FixSectors<RecSize / 1024, 1024>(pRecord, pUsa, sectors, stride);
+        break;
+    case 2048:
+        whole = FixSectors<RecSize / 2048, 2048>(pRecord, pUsa, sectors, stride);
+        break;
+    case 4096:
+        whole = FixSectors<RecSize / 4096, 4096>(pRecord, pUsa, sectors, stride);
+        break;
+    default:
+        whole = FixSectors<0, 0>(pRecord, pUsa, sectors, stride);
+        break;
+    }
+
+    if (!whole)
+    {
+        memcpy(pRecord, sBaadSig, 4);
+        m_counts.torn++;
+        return false;
+    }
+    return true;
+}
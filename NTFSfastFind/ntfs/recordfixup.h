@@ -0,0 +1,101 @@
+// ------------------------------------------------------------------------------------------------
+// MFT record update sequence (fixup) check and repair, applied once after each read.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+
+// ------------------------------------------------------------------------------------------------
+// NTFS replaces the last WORD of each sector of an MFT record with the update sequence number
+// (USN) when writing it and keeps the original WORDs in the update sequence array. Apply checks
+// every sector still ends with the USN and restores the original WORDs, so parsers can use the
+// record as is. Records with a bad header or a sector which does not end with the USN (torn
+// write) get the "BAAD" signature, as NTFS does, and are skipped by the parsers.
+//
+// Stride between fixups is the record size divided by the array length, it must be the sector
+// size from the boot sector or 512 (NTFS uses 512 byte strides on 4K sector disks).
+// 1 KB and 4 KB records use kernels built for their size, the array length must then match
+// the record size over a 512 byte or sector size stride, and the sector loops run a constant
+// count.
+//
+//  Ex:
+//      RecordFixup fixup(1024, 512);
+//      fixup.Apply(pRecords, recordsLen);
+//      if (fixup.GetCounts().torn != 0) ...
+
+class RecordFixup
+{
+public:
+    struct Counts
+    {
+        Counts() :
+            records(0), bad(0), torn(0)
+        { }
+
+        void Add(const Counts& other)
+        {
+            records += other.records;
+            bad     += other.bad;
+            torn    += other.torn;
+        }
+
+        LONGLONG    records;    // Records checked.
+        LONGLONG    bad;        // Marked "BAAD" on disk or invalid update sequence array.
+        LONGLONG    torn;       // Sector did not end with update sequence number.
+    };
+
+    RecordFixup(DWORD recSize, DWORD bytesPerSector) :
+        m_recSize(recSize), m_bytesPerSector(bytesPerSector)
+    { }
+
+    // Fix each whole record of block in place, unused (zero) records are left as is.
+    void Apply(BYTE* pData, size_t len);
+
+    const Counts& GetCounts() const
+    { return m_counts; }
+
+    static const DWORD sMinStride = 512;
+
+private:
+    // RecSize 0 = any record size, use m_recSize.
+    template <DWORD RecSize> 
+    void ApplyAll(BYTE* pData, size_t len);
+
+    // Return false if record is bad or torn, it is then marked "BAAD".
+    template <DWORD RecSize> 
+    bool ApplyRecord(BYTE* pRecord);
+
+    template <DWORD RecSize> 
+    DWORD Stride(DWORD usaCount) const;
+
+    DWORD   m_recSize;
+    DWORD   m_bytesPerSector;
+    Counts  m_counts;
+};
@@ -0,0 +1,128 @@
+// ------------------------------------------------------------------------------------------------
+// Sector aligned buffers for unbuffered (direct) volume reads.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "AlignedBuffer.h"
+
+#include <malloc.h>
+#include <new>
+
+// ------------------------------------------------------------------------------------------------
+AlignedBuffer::~AlignedBuffer()
+{
+    if (m_pData != NULL)
+        _aligned_free(m_pData);
+}
+
+// ------------------------------------------------------------------------------------------------
+AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& other)
+{
+    if (this != &other)
+    {
+        if (m_pData != NULL)
+            _aligned_free(m_pData);
+        m_pData = other.m_pData;
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+        other.m_pData = NULL;
+        other.m_size = other.m_capacity = 0;
+    }
+    return *this;
+}
+
+// ------------------------------------------------------------------------------------------------
+void AlignedBuffer::resize(size_t len)
+{
+    if (len > m_capacity)
+    {
+        size_t capacity = (len + sAlignment - 1) / sAlignment * sAlignment;
+        BYTE* pData = (BYTE*)_aligned_malloc(capacity, sAlignment);
+        if (pData == NULL)
+            throw std::bad_alloc();
+
+        if (m_pData != NULL)
+            _aligned_free(m_pData);
+        m_pData = pData;
+        m_capacity = capacity;
+    }
+    m_size = len;
+}
+
+// ------------------------------------------------------------------------------------------------
+AlignedPool::~AlignedPool()
+{
+    for (unsigned bufIdx = 0; bufIdx < m_free.size(); bufIdx++)
+        delete m_free[bufIdx];
+}
+
+// ------------------------------------------------------------------------------------------------
+// Best fit from released buffers, else grow the largest released buffer, else allocate.
+AlignedBuffer* AlignedPool::Get(size_t len)
+{
+    AlignedBuffer* pBuffer = NULL;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        size_t bestIdx = m_free.size();
+        for (size_t bufIdx = 0; bufIdx < m_free.size(); bufIdx++)
+        {
+            size_t capacity = m_free[bufIdx]->capacity();
+            if (bestIdx == m_free.size())
+                bestIdx = bufIdx;
+            else if (capacity >= len)
+            {
+                size_t bestCapacity = m_free[bestIdx]->capacity();
+                if (bestCapacity < len || capacity < bestCapacity)
+                    bestIdx = bufIdx;
+            }
+            else if (m_free[bestIdx]->capacity() < len && capacity > m_free[bestIdx]->capacity())
+                bestIdx = bufIdx;
+        }
+
+        if (bestIdx != m_free.size())
+        {
+            pBuffer = m_free[bestIdx];
+            m_free[bestIdx] = m_free.back();
+            m_free.pop_back();
+        }
+    }
+
+    if (pBuffer == NULL)
+        pBuffer = new AlignedBuffer();
+    pBuffer->resize(len);
+    return pBuffer;
+}
+
+// ------------------------------------------------------------------------------------------------
+void AlignedPool::Release(AlignedBuffer* pBuffer)
+{
+    if (pBuffer == NULL)
+        return;
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_free.push_back(pBuffer);
+}
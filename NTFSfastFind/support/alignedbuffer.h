@@ -0,0 +1,114 @@
+// ------------------------------------------------------------------------------------------------
+// Sector aligned buffers for unbuffered (direct) volume reads.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+
+#include <mutex>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Heap buffer aligned to a page, which satisfies the buffer alignment of any sector size
+// for FILE_FLAG_NO_BUFFERING reads. Unlike Buffer, contents are not kept when it grows.
+class AlignedBuffer
+{
+public:
+    static const DWORD sAlignment = 4096;
+
+    AlignedBuffer() : 
+        m_pData(NULL), m_size(0), m_capacity(0)
+    { }
+
+    explicit AlignedBuffer(size_t len) : 
+        m_pData(NULL), m_size(0), m_capacity(0)
+    { resize(len); }
+
+    AlignedBuffer(AlignedBuffer&& other) :
+        m_pData(other.m_pData), m_size(other.m_size), m_capacity(other.m_capacity)
+    {
+        other.m_pData = NULL;
+        other.m_size = other.m_capacity = 0;
+    }
+
+    ~AlignedBuffer();
+
+    AlignedBuffer& operator=(AlignedBuffer&& other);
+
+    // Throws std::bad_alloc if memory is not available.
+    void resize(size_t len);
+
+    BYTE* Data()
+    { return m_pData; }
+
+    size_t size() const
+    { return m_size; }
+
+    size_t capacity() const
+    { return m_capacity; }
+
+private:
+    AlignedBuffer(const AlignedBuffer&);
+    AlignedBuffer& operator=(const AlignedBuffer&);
+
+    BYTE*   m_pData;
+    size_t  m_size;
+    size_t  m_capacity;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Reusable aligned buffers, so unbuffered reads do not allocate a buffer per read.
+// Thread safe.
+//
+//  Ex:
+//      AlignedBuffer* pBuffer = pool.Get(len);
+//      ... read into pBuffer->Data()
+//      pool.Release(pBuffer);
+
+class AlignedPool
+{
+public:
+    AlignedPool()
+    { }
+
+    ~AlignedPool();
+
+    // Return buffer of at least len bytes, a released buffer is reused if possible.
+    AlignedBuffer* Get(size_t len);
+
+    void Release(AlignedBuffer* pBuffer);
+
+private:
+    AlignedPool(const AlignedPool&);
+    AlignedPool& operator=(const AlignedPool&);
+
+    std::mutex                  m_lock;
+    std::vector<AlignedBuffer*> m_free;
+};
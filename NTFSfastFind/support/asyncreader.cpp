@@ -0,0 +1,265 @@
+// ------------------------------------------------------------------------------------------------
+// Asynchronous volume reader, keep several reads in flight (queue depth).
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "AsyncReader.h"
+
+#include <assert.h>
+
+// ------------------------------------------------------------------------------------------------
+AsyncReader::AsyncReader(VolumeReader& reader, unsigned queueDepth) :
+    m_reader(reader),
+    m_hnd(reader.OverlappedHandle()),
+    m_slots(max(queueDepth, 1u)),
+    m_head(0),
+    m_count(0),
+    m_stop(false)
+{
+    for (unsigned slotIdx = 0; slotIdx < m_slots.size(); slotIdx++)
+    {
+        Slot& slot = m_slots[slotIdx];
+        ZeroMemory(&slot.overlapped, sizeof(slot.overlapped));
+        slot.event = NULL;
+        slot.pPad = NULL;
+        slot.padHead = 0;
+        slot.state = eFree;
+        slot.error = ERROR_SUCCESS;
+    }
+
+    if (IsOverlapped())
+    {
+        for (unsigned slotIdx = 0; slotIdx < m_slots.size(); slotIdx++)
+        {
+            m_slots[slotIdx].event = CreateEvent(NULL, TRUE, FALSE, NULL);
+            if (m_slots[slotIdx].event == NULL)
+            {
+                m_hnd = INVALID_HANDLE_VALUE;   // Use threads.
+                break;
+            }
+        }
+    }
+
+    if (!IsOverlapped())
+    {
+        for (unsigned threadIdx = 0; threadIdx < m_slots.size(); threadIdx++)
+            m_threads.push_back(std::thread(&AsyncReader::ReadStage, this));
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+AsyncReader::~AsyncReader()
+{
+    if (IsOverlapped())
+    {
+        // Buffers belong to caller, do not return while reads are in flight.
+        for (unsigned slotIdx = 0; slotIdx < m_slots.size(); slotIdx++)
+        {
+            Slot& slot = m_slots[slotIdx];
+            if (slot.state == eQueued)
+            {
+                DWORD dwBytes;
+                CancelIoEx(m_hnd, &slot.overlapped);
+                GetOverlappedResult(m_hnd, &slot.overlapped, &dwBytes, TRUE);
+            }
+            if (slot.pPad != NULL)
+                m_reader.BufferPool()->Release(slot.pPad);
+        }
+    }
+    else
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stop = true;
+        }
+        m_queued.notify_all();
+        for (unsigned threadIdx = 0; threadIdx < m_threads.size(); threadIdx++)
+            m_threads[threadIdx].join();
+    }
+
+    for (unsigned slotIdx = 0; slotIdx < m_slots.size(); slotIdx++)
+        if (m_slots[slotIdx].event != NULL)
+            CloseHandle(m_slots[slotIdx].event);
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD AsyncReader::Submit(LONGLONG pos, void* pDst, DWORD len, size_t tag)
+{
+    assert(!IsFull());
+    if (IsFull())
+        return ERROR_BUSY;
+
+    size_t slotIdx = (m_head + m_count) % m_slots.size();
+    Slot& slot = m_slots[slotIdx];
+    slot.pos = pos;
+    slot.completion.tag = tag;
+    slot.completion.pDst = (BYTE*)pDst;
+    slot.completion.len = len;
+    slot.completion.outLen = 0;
+    slot.error = ERROR_SUCCESS;
+    m_count++;
+
+    if (IsOverlapped())
+    {
+        // Unbuffered handle, pad unaligned request to whole sectors.
+        BYTE* pRead = (BYTE*)pDst;
+        DWORD readLen = len;
+        DWORD align = m_reader.Alignment();
+        slot.pPad = NULL;
+        if (align > 1 && ((pos | len | (ULONG_PTR)pDst) & (align - 1)) != 0)
+        {
+            LONGLONG alignedPos = pos & ~(LONGLONG)(align - 1);
+            slot.padHead = (DWORD)(pos - alignedPos);
+            readLen = (slot.padHead + len + align - 1) & ~(align - 1);
+            slot.pPad = m_reader.BufferPool()->Get(readLen);
+            pRead = slot.pPad->Data();
+            pos = alignedPos;
+        }
+
+        LARGE_INTEGER offset;
+        offset.QuadPart = pos;
+        ZeroMemory(&slot.overlapped, sizeof(slot.overlapped));
+        slot.overlapped.Offset = offset.LowPart;
+        slot.overlapped.OffsetHigh = offset.HighPart;
+        slot.overlapped.hEvent = slot.event;
+        ResetEvent(slot.event);
+
+        slot.state = eQueued;
+        if (!ReadFile(m_hnd, pRead, readLen, NULL, &slot.overlapped))
+        {
+            DWORD error = GetLastError();
+            if (error != ERROR_IO_PENDING)
+            {
+                // Failed or end of source, reported by Wait.
+                slot.state = eDone;
+                slot.error = (error == ERROR_HANDLE_EOF) ? ERROR_SUCCESS : error;
+            }
+        }
+        return ERROR_SUCCESS;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        slot.state = eQueued;
+        m_todo.push_back(slotIdx);
+    }
+    m_queued.notify_one();
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD AsyncReader::Wait(Completion& completion)
+{
+    if (m_count == 0)
+        return ERROR_NO_MORE_ITEMS;
+
+    Slot& slot = m_slots[m_head];
+    if (IsOverlapped())
+    {
+        if (slot.state == eQueued)
+        {
+            DWORD dwBytes = 0;
+            if (!GetOverlappedResult(m_hnd, &slot.overlapped, &dwBytes, TRUE))
+            {
+                DWORD error = GetLastError();
+                if (error != ERROR_HANDLE_EOF)
+                    slot.error = error;
+            }
+            slot.completion.outLen = dwBytes;
+            slot.state = eDone;
+        }
+
+        if (slot.pPad != NULL)
+        {
+            Completion& padded = slot.completion;
+            DWORD dwBytes = padded.outLen;
+            padded.outLen = (dwBytes > slot.padHead) ? min(padded.len, dwBytes - slot.padHead) : 0;
+            memcpy(padded.pDst, slot.pPad->Data() + slot.padHead, padded.outLen);
+            m_reader.BufferPool()->Release(slot.pPad);
+            slot.pPad = NULL;
+        }
+    }
+    else
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_done.wait(lock, [&] { return slot.state == eDone; });
+    }
+
+    completion = slot.completion;
+    DWORD error = slot.error;
+    slot.state = eFree;
+    m_head = (m_head + 1) % m_slots.size();
+    m_count--;
+    return error;
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncReader::Drain()
+{
+    Completion completion;
+    while (m_count != 0)
+        Wait(completion);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Thread pool worker, read until request is full or end of source.
+void AsyncReader::ReadStage()
+{
+    for (;;)
+    {
+        size_t slotIdx;
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_queued.wait(lock, [this] { return !m_todo.empty() || m_stop; });
+            if (m_stop)
+                break;
+            slotIdx = m_todo.front();
+            m_todo.pop_front();
+        }
+
+        Slot& slot = m_slots[slotIdx];
+        Completion& completion = slot.completion;
+        DWORD error = ERROR_SUCCESS;
+        while (completion.outLen < completion.len)
+        {
+            DWORD dwBytes = 0;
+            error = m_reader.Read(slot.pos + completion.outLen, completion.pDst + completion.outLen, 
+                completion.len - completion.outLen, dwBytes);
+            if (error != ERROR_SUCCESS || dwBytes == 0)
+                break;
+            completion.outLen += dwBytes;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            slot.error = error;
+            slot.state = eDone;
+        }
+        m_done.notify_all();
+    }
+}
@@ -0,0 +1,124 @@
+// ------------------------------------------------------------------------------------------------
+// Asynchronous volume reader, keep several reads in flight (queue depth).
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+#include "VolumeReader.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Queue up to queueDepth reads, completions are returned in submit order.
+// Uses overlapped I/O when the reader provides an overlapped handle, else a pool of
+// queueDepth threads calling VolumeReader::Read (ex: mapped image file). Unaligned 
+// requests to an unbuffered reader are padded to whole sectors.
+//
+//  Ex:
+//      AsyncReader asyncReader(*pReader, 16);
+//      while (more reads or asyncReader.Pending() != 0)
+//          if (more reads and !asyncReader.IsFull())
+//              asyncReader.Submit(pos, pBuf, len, tag);
+//          else
+//              asyncReader.Wait(completion);
+
+class AsyncReader
+{
+public:
+    struct Completion
+    {
+        size_t      tag;            // Caller value given to Submit.
+        BYTE*       pDst;
+        DWORD       len;            // Requested length.
+        DWORD       outLen;         // Bytes read, less than len at end of source.
+    };
+
+    AsyncReader(VolumeReader& reader, unsigned queueDepth);
+    ~AsyncReader();
+
+    unsigned QueueDepth() const
+    { return (unsigned)m_slots.size(); }
+
+    size_t Pending() const
+    { return m_count; }
+
+    bool IsFull() const
+    { return m_count == m_slots.size(); }
+
+    bool IsOverlapped() const
+    { return m_hnd != INVALID_HANDLE_VALUE; }
+
+    // Queue read, queue must not be full.
+    // Return 0 on success, else last error.
+    DWORD Submit(LONGLONG pos, void* pDst, DWORD len, size_t tag);
+
+    // Wait for oldest read to complete.
+    // Return 0 on success, ERROR_NO_MORE_ITEMS if nothing is queued, else last error.
+    DWORD Wait(Completion& completion);
+
+    // Wait for all queued reads, results are discarded. Call before releasing buffers
+    // after an error.
+    void Drain();
+
+private:
+    enum State { eFree, eQueued, eDone };
+
+    struct Slot
+    {
+        OVERLAPPED  overlapped;
+        HANDLE      event;
+        LONGLONG    pos;
+        Completion  completion;
+        DWORD       error;
+        State       state;
+        AlignedBuffer* pPad;        // Sector aligned read when unbuffered and request is not.
+        DWORD       padHead;        // Offset of request in pPad.
+    };
+
+    void ReadStage();
+
+    VolumeReader&       m_reader;
+    HANDLE              m_hnd;      // Overlapped handle or INVALID_HANDLE_VALUE.
+    std::vector<Slot>   m_slots;    // Ring, oldest at m_head.
+    size_t              m_head;
+    size_t              m_count;
+
+    // Thread pool state, guarded by m_lock.
+    std::mutex              m_lock;
+    std::condition_variable m_queued;   // Threads wait for reads.
+    std::condition_variable m_done;     // Wait() waits for oldest read.
+    std::deque<size_t>      m_todo;
+    bool                    m_stop;
+    std::vector<std::thread> m_threads;
+};
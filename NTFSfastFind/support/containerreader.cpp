@@ -0,0 +1,502 @@
+// ------------------------------------------------------------------------------------------------
+// Virtual disk container readers (VHD, VHDX, split raw segments).
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "ContainerReader.h"
+
+#include <algorithm>
+#include <string>
+
+#pragma pack(push, curAlignment)
+#pragma pack(1)
+
+// VHD footer, last 512 bytes of file (copy at start of dynamic disks), big endian.
+struct VHD_FOOTER
+{
+    char        cookie[8];          // "conectix"
+    DWORD       features;
+    DWORD       version;
+    ULONGLONG   dataOffset;         // Dynamic header offset, all ones for fixed disk.
+    DWORD       timeStamp;
+    char        creatorApp[4];
+    DWORD       creatorVersion;
+    DWORD       creatorOS;
+    ULONGLONG   originalSize;
+    ULONGLONG   currentSize;
+    DWORD       geometry;
+    DWORD       diskType;           // 2=fixed, 3=dynamic, 4=differencing
+    DWORD       checksum;
+    BYTE        uniqueId[16];
+    BYTE        savedState;
+    BYTE        reserved[427];
+};
+
+// VHD dynamic disk header, big endian.
+struct VHD_DYNAMIC_HEADER
+{
+    char        cookie[8];          // "cxsparse"
+    ULONGLONG   dataOffset;
+    ULONGLONG   tableOffset;        // Block allocation table.
+    DWORD       headerVersion;
+    DWORD       maxTableEntries;
+    DWORD       blockSize;          // Default 2MB.
+    DWORD       checksum;
+    BYTE        parentUniqueId[16];
+    DWORD       parentTimeStamp;
+    DWORD       reserved1;
+    BYTE        parentName[512];
+    BYTE        parentLocators[8 * 24];
+    BYTE        reserved2[256];
+};
+
+struct VHDX_GUID
+{
+    DWORD       data1;
+    WORD        data2;
+    WORD        data3;
+    BYTE        data4[8];
+};
+
+// VHDX header, at 64KB and 128KB, current one has the larger sequence number.
+struct VHDX_HEADER
+{
+    char        signature[4];       // "head"
+    DWORD       checksum;
+    ULONGLONG   sequenceNumber;
+    VHDX_GUID   fileWriteGuid;
+    VHDX_GUID   dataWriteGuid;
+    VHDX_GUID   logGuid;            // Non zero if log must be replayed.
+    WORD        logVersion;
+    WORD        version;
+    DWORD       logLength;
+    ULONGLONG   logOffset;
+};
+
+struct VHDX_REGION_TABLE_HEADER
+{
+    char        signature[4];       // "regi"
+    DWORD       checksum;
+    DWORD       entryCount;
+    DWORD       reserved;
+};
+
+struct VHDX_REGION_ENTRY
+{
+    VHDX_GUID   guid;
+    ULONGLONG   fileOffset;
+    DWORD       length;
+    DWORD       required;
+};
+
+struct VHDX_METADATA_HEADER
+{
+    char        signature[8];       // "metadata"
+    WORD        reserved;
+    WORD        entryCount;
+    DWORD       reserved2[5];
+};
+
+struct VHDX_METADATA_ENTRY
+{
+    VHDX_GUID   itemId;
+    DWORD       offset;             // From start of metadata region.
+    DWORD       length;
+    DWORD       flags;
+    DWORD       reserved;
+};
+#pragma pack(pop, curAlignment)
+
+static const DWORD sVhdSector = 512;
+static const DWORD sVhdUnused = 0xFFFFFFFF;
+
+static const LONGLONG sVhdxHeaderOffset[] = { 64 << 10, 128 << 10 };
+static const LONGLONG sVhdxRegionOffset = 192 << 10;
+static const DWORD sVhdxMetadataMax = 1 << 20;
+static const ULONGLONG sVhdxMB = 1 << 20;
+
+static const VHDX_GUID sVhdxBatGuid = 
+    { 0x2DC27766, 0xF623, 0x4200, { 0x9D, 0x64, 0x11, 0x5E, 0x9B, 0xFD, 0x4A, 0x08 } };
+static const VHDX_GUID sVhdxMetadataGuid = 
+    { 0x8B7CA206, 0x4790, 0x4B9A, { 0xB8, 0xFE, 0x57, 0x5F, 0x05, 0x0F, 0x88, 0x6E } };
+static const VHDX_GUID sVhdxFileParamsGuid = 
+    { 0xCAA16737, 0xFA36, 0x4D43, { 0xB3, 0xB6, 0x33, 0xF0, 0xAA, 0x44, 0xE7, 0x6B } };
+static const VHDX_GUID sVhdxDiskSizeGuid = 
+    { 0x2FA54224, 0xCD1B, 0x4876, { 0xB2, 0x11, 0x5D, 0xBE, 0xD8, 0x3B, 0xF4, 0xB8 } };
+static const VHDX_GUID sVhdxSectorSizeGuid = 
+    { 0x8141BF1D, 0xA96F, 0x4709, { 0xBA, 0x47, 0xF2, 0x33, 0xA8, 0xFA, 0xAB, 0x5F } };
+
+// VHDX block allocation table entry states, low 3 bits.
+static const ULONGLONG sVhdxFullyPresent = 6;
+static const ULONGLONG sVhdxPartiallyPresent = 7;
+static const DWORD sVhdxHasParent = 2;
+
+// ------------------------------------------------------------------------------------------------
+// Read exactly len bytes, return 0 on success, else last error.
+static DWORD ReadExact(VolumeReader& reader, LONGLONG offset, void* pDst, DWORD len)
+{
+    DWORD dwBytes = 0;
+    DWORD error = reader.Read(offset, pDst, len, dwBytes);
+    if (error == ERROR_SUCCESS && dwBytes != len)
+        error = ERROR_HANDLE_EOF;
+    return error;
+}
+
+// ------------------------------------------------------------------------------------------------
+static bool IsSameGuid(const VHDX_GUID& guid1, const VHDX_GUID& guid2)
+{
+    return memcmp(&guid1, &guid2, sizeof(VHDX_GUID)) == 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Split request at block boundaries, unallocated blocks are zero filled without any I/O.
+DWORD BlockMapReader::Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen)
+{
+    outLen = 0;
+    BYTE* pOut = (BYTE*)pDst;
+    while (outLen < len && offset < m_size)
+    {
+        size_t blockIdx = (size_t)(offset / m_blockSize);
+        DWORD blockOff = (DWORD)(offset % m_blockSize);
+        DWORD pieceLen = (DWORD)min((LONGLONG)min(len - outLen, m_blockSize - blockOff), m_size - offset);
+
+        LONGLONG filePos = (blockIdx < m_blockMap.size()) ? m_blockMap[blockIdx] : sUnallocated;
+        if (filePos == sUnallocated)
+        {
+            ZeroMemory(pOut, pieceLen);
+        }
+        else
+        {
+            DWORD error = ReadExact(m_file, filePos + blockOff, pOut, pieceLen);
+            if (error != ERROR_SUCCESS)
+                return error;
+        }
+
+        pOut += pieceLen;
+        offset += pieceLen;
+        outLen += pieceLen;
+    }
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// https://learn.microsoft.com/en-us/windows/win32/vstor/about-vhd
+DWORD VhdReader::Open(const wchar_t* path, DWORD flags)
+{
+    DWORD error = m_file.Open(path, flags);
+    if (error != ERROR_SUCCESS)
+        return error;
+
+    // Dynamic disks start with a copy of the footer.
+    VHD_FOOTER footer;
+    error = ReadExact(m_file, 0, &footer, sizeof(footer));
+    if (error != ERROR_SUCCESS)
+        return error;
+    if (memcmp(footer.cookie, "conectix", 8) != 0)
+        return ERROR_INVALID_DATA;
+    if (_byteswap_ulong(footer.diskType) != 3)
+        return ERROR_NOT_SUPPORTED;
+
+    VHD_DYNAMIC_HEADER header;
+    error = ReadExact(m_file, (LONGLONG)_byteswap_uint64(footer.dataOffset), &header, sizeof(header));
+    if (error != ERROR_SUCCESS)
+        return error;
+    if (memcmp(header.cookie, "cxsparse", 8) != 0)
+        return ERROR_INVALID_DATA;
+
+    m_size = (LONGLONG)_byteswap_uint64(footer.currentSize);
+    m_blockSize = _byteswap_ulong(header.blockSize);
+    DWORD entries = _byteswap_ulong(header.maxTableEntries);
+    if (m_blockSize == 0 || (m_blockSize % sVhdSector) != 0 || m_size <= 0 
+        || (ULONGLONG)entries * m_blockSize < (ULONGLONG)m_size)
+        return ERROR_INVALID_DATA;
+
+    // Table may list more entries than the disk size needs, only those are read. It must
+    // lie in the file.
+    entries = (DWORD)min((ULONGLONG)entries, ((ULONGLONG)m_size + m_blockSize - 1) / m_blockSize);
+    ULONGLONG tableOffset = _byteswap_uint64(header.tableOffset);
+    ULONGLONG tableBytes = (ULONGLONG)entries * sizeof(DWORD);
+    if (tableBytes > MAXDWORD || tableOffset > (ULONGLONG)m_file.Size() || tableBytes > (ULONGLONG)m_file.Size() - tableOffset)
+        return ERROR_INVALID_DATA;
+
+    std::vector<DWORD> bat(entries);
+    error = ReadExact(m_file, (LONGLONG)tableOffset, bat.data(), (DWORD)tableBytes);
+    if (error != ERROR_SUCCESS)
+        return error;
+
+    // Each block starts with a sector bitmap, padded to whole sectors. Without a parent 
+    // disk every sector of an allocated block is used as is.
+    DWORD bitmapSize = ((m_blockSize / sVhdSector + 7) / 8 + sVhdSector - 1) / sVhdSector * sVhdSector;
+    m_blockMap.resize(entries);
+    for (DWORD blockIdx = 0; blockIdx < entries; blockIdx++)
+    {
+        DWORD sector = _byteswap_ulong(bat[blockIdx]);
+        m_blockMap[blockIdx] = (sector == sVhdUnused) ? sUnallocated : (LONGLONG)sector * sVhdSector + bitmapSize;
+    }
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// https://learn.microsoft.com/en-us/openspecs/windows_protocols/ms-vhdx
+// Checksums are not verified.
+DWORD VhdxReader::Open(const wchar_t* path, DWORD flags)
+{
+    DWORD error = m_file.Open(path, flags);
+    if (error != ERROR_SUCCESS)
+        return error;
+
+    char fileId[8];
+    error = ReadExact(m_file, 0, fileId, sizeof(fileId));
+    if (error != ERROR_SUCCESS)
+        return error;
+    if (memcmp(fileId, "vhdxfile", 8) != 0)
+        return ERROR_INVALID_DATA;
+
+    // Current header.
+    VHDX_HEADER header;
+    bool haveHeader = false;
+    for (unsigned hdrIdx = 0; hdrIdx < ARRAYSIZE(sVhdxHeaderOffset); hdrIdx++)
+    {
+        VHDX_HEADER nextHeader;
+        if (ReadExact(m_file, sVhdxHeaderOffset[hdrIdx], &nextHeader, sizeof(nextHeader)) == ERROR_SUCCESS
+            && memcmp(nextHeader.signature, "head", 4) == 0
+            && (!haveHeader || nextHeader.sequenceNumber > header.sequenceNumber))
+        {
+            header = nextHeader;
+            haveHeader = true;
+        }
+    }
+    if (!haveHeader)
+        return ERROR_INVALID_DATA;
+
+    static const VHDX_GUID sNoLog = { 0 };
+    if (!IsSameGuid(header.logGuid, sNoLog))
+        return ERROR_NOT_SUPPORTED;     // Not cleanly closed, metadata may be stale.
+
+    // Region table locates BAT and metadata.
+    Buffer regions;
+    regions.resize(64 << 10);
+    error = ReadExact(m_file, sVhdxRegionOffset, regions.Data(), (DWORD)regions.size());
+    if (error != ERROR_SUCCESS)
+        return error;
+    const VHDX_REGION_TABLE_HEADER* pRegionHdr = (const VHDX_REGION_TABLE_HEADER*)regions.Data();
+    if (memcmp(pRegionHdr->signature, "regi", 4) != 0)
+        return ERROR_INVALID_DATA;
+
+    const VHDX_REGION_ENTRY* pBatRegion = NULL;
+    const VHDX_REGION_ENTRY* pMetaRegion = NULL;
+    const VHDX_REGION_ENTRY* pRegion = (const VHDX_REGION_ENTRY*)(pRegionHdr + 1);
+    DWORD regionCnt = min(pRegionHdr->entryCount, (DWORD)((regions.size() - sizeof(*pRegionHdr)) / sizeof(*pRegion)));
+    for (DWORD regionIdx = 0; regionIdx < regionCnt; regionIdx++, pRegion++)
+    {
+        if (IsSameGuid(pRegion->guid, sVhdxBatGuid))
+            pBatRegion = pRegion;
+        else if (IsSameGuid(pRegion->guid, sVhdxMetadataGuid))
+            pMetaRegion = pRegion;
+    }
+    if (pBatRegion == NULL || pMetaRegion == NULL || pMetaRegion->length > sVhdxMetadataMax)
+        return ERROR_INVALID_DATA;
+
+    // Metadata items, block size, virtual disk size and logical sector size.
+    Buffer metadata;
+    metadata.resize(pMetaRegion->length);
+    error = ReadExact(m_file, pMetaRegion->fileOffset, metadata.Data(), pMetaRegion->length);
+    if (error != ERROR_SUCCESS)
+        return error;
+    const VHDX_METADATA_HEADER* pMetaHdr = (const VHDX_METADATA_HEADER*)metadata.Data();
+    if (metadata.size() < sizeof(*pMetaHdr) || memcmp(pMetaHdr->signature, "metadata", 8) != 0)
+        return ERROR_INVALID_DATA;
+
+    DWORD metaFlags = 0;
+    DWORD sectorSize = 0;
+    const VHDX_METADATA_ENTRY* pItem = (const VHDX_METADATA_ENTRY*)(pMetaHdr + 1);
+    for (WORD itemIdx = 0; itemIdx < pMetaHdr->entryCount; itemIdx++, pItem++)
+    {
+        if ((const BYTE*)(pItem + 1) > metadata.Data() + metadata.size() 
+            || (size_t)pItem->offset + pItem->length > metadata.size())
+            return ERROR_INVALID_DATA;
+
+        const BYTE* pValue = metadata.Data() + pItem->offset;
+        if (IsSameGuid(pItem->itemId, sVhdxFileParamsGuid) && pItem->length >= 8)
+        {
+            m_blockSize = ((const DWORD*)pValue)[0];
+            metaFlags = ((const DWORD*)pValue)[1];
+        }
+        else if (IsSameGuid(pItem->itemId, sVhdxDiskSizeGuid) && pItem->length >= 8)
+            m_size = *(const LONGLONG*)pValue;
+        else if (IsSameGuid(pItem->itemId, sVhdxSectorSizeGuid) && pItem->length >= 4)
+            sectorSize = *(const DWORD*)pValue;
+    }
+    if ((metaFlags & sVhdxHasParent) != 0)
+        return ERROR_NOT_SUPPORTED;
+    // Spec allows 512 or 4096 byte logical sectors and 1 MB to 256 MB power of two blocks.
+    const DWORD sMinBlock = 1 << 20;
+    const DWORD sMaxBlock = 256 << 20;
+    if (m_blockSize < sMinBlock || m_blockSize > sMaxBlock || (m_blockSize & (m_blockSize - 1)) != 0 
+        || (sectorSize != 512 && sectorSize != 4096) || m_size <= 0)
+        return ERROR_INVALID_DATA;
+
+    // BAT holds a sector bitmap entry after every chunkRatio payload block entries.
+    ULONGLONG chunkRatio = ((ULONGLONG)1 << 23) * sectorSize / m_blockSize;
+    if (chunkRatio == 0)
+        return ERROR_INVALID_DATA;
+    size_t blocks = (size_t)((m_size + m_blockSize - 1) / m_blockSize);
+    size_t batEntries = blocks + (size_t)((blocks - 1) / chunkRatio);
+    if (batEntries * sizeof(ULONGLONG) > pBatRegion->length)
+        return ERROR_INVALID_DATA;
+
+    std::vector<ULONGLONG> bat(batEntries);
+    error = ReadExact(m_file, pBatRegion->fileOffset, bat.data(), (DWORD)(batEntries * sizeof(ULONGLONG)));
+    if (error != ERROR_SUCCESS)
+        return error;
+
+    m_blockMap.resize(blocks);
+    for (size_t blockIdx = 0; blockIdx < blocks; blockIdx++)
+    {
+        ULONGLONG entry = bat[blockIdx + (size_t)(blockIdx / chunkRatio)];
+        ULONGLONG state = entry & 7;
+        bool present = (state == sVhdxFullyPresent || state == sVhdxPartiallyPresent);
+        m_blockMap[blockIdx] = present ? (LONGLONG)((entry >> 20) * sVhdxMB) : sUnallocated;
+    }
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD SplitImageReader::Open(const wchar_t* firstPath, DWORD flags)
+{
+    std::wstring path(firstPath);
+    size_t digitPos = path.find_last_not_of(L"0123456789") + 1;
+    size_t digitCnt = path.length() - digitPos;
+    if (digitCnt == 0)
+        return ERROR_INVALID_NAME;
+    unsigned segmentNum = (unsigned)wcstoul(path.c_str() + digitPos, NULL, 10);
+
+    for (;;)
+    {
+        HandleReader* pSegment = new HandleReader();
+        SharePtr<HandleReader> segment(pSegment);
+        DWORD error = pSegment->Open(path.c_str(), flags);
+        if (error != ERROR_SUCCESS)
+            return m_segments.empty() ? error : ERROR_SUCCESS;  // Past last segment.
+
+        LONGLONG segmentSize = pSegment->Size();
+        if (segmentSize == 0)
+            return m_segments.empty() ? ERROR_HANDLE_EOF : ERROR_SUCCESS;
+        m_size += segmentSize;
+        m_segments.push_back(segment);
+        m_segmentEnd.push_back(m_size);
+
+        wchar_t digits[16];
+        _snwprintf_s(digits, ARRAYSIZE(digits), L"%0*u", (int)digitCnt, ++segmentNum);
+        path.replace(digitPos, std::wstring::npos, digits);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Read may span segments.
+DWORD SplitImageReader::Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen)
+{
+    outLen = 0;
+    BYTE* pOut = (BYTE*)pDst;
+    while (outLen < len && offset >= 0 && offset < m_size)
+    {
+        size_t segIdx = std::upper_bound(m_segmentEnd.begin(), m_segmentEnd.end(), offset) - m_segmentEnd.begin();
+        LONGLONG segStart = (segIdx == 0) ? 0 : m_segmentEnd[segIdx - 1];
+        DWORD pieceLen = (DWORD)min((LONGLONG)(len - outLen), m_segmentEnd[segIdx] - offset);
+
+        DWORD error = ReadExact(*m_segments[segIdx], offset - segStart, pOut, pieceLen);
+        if (error != ERROR_SUCCESS)
+            return error;
+
+        pOut += pieceLen;
+        offset += pieceLen;
+        outLen += pieceLen;
+    }
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Return true if name ends in .NNN, ex: disk.001
+static bool IsSplitName(const wchar_t* path)
+{
+    const wchar_t* pExt = wcsrchr(path, L'.');
+    return pExt != NULL && wcslen(pExt) == 4 
+        && iswdigit(pExt[1]) && iswdigit(pExt[2]) && iswdigit(pExt[3]);
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD OpenImageReader(const wchar_t* path, bool direct, SharePtr<VolumeReader>& reader)
+{
+    DWORD flags = direct ? FILE_FLAG_NO_BUFFERING : FILE_FLAG_RANDOM_ACCESS;
+
+    HandleReader probe;
+    DWORD error = probe.Open(path, flags);
+    if (error != ERROR_SUCCESS)
+        return error;
+
+    // VHDX starts with its file identifier, VHD ends with its footer.
+    char fileId[8];
+    LONGLONG fileSize = probe.Size();
+    if (ReadExact(probe, 0, fileId, sizeof(fileId)) == ERROR_SUCCESS && memcmp(fileId, "vhdxfile", 8) == 0)
+    {
+        VhdxReader* pVhdx = new VhdxReader();
+        reader = pVhdx;
+        return pVhdx->Open(path, flags);
+    }
+
+    VHD_FOOTER footer;
+    if (fileSize >= (LONGLONG)sizeof(footer)
+        && ReadExact(probe, fileSize - sizeof(footer), &footer, sizeof(footer)) == ERROR_SUCCESS
+        && memcmp(footer.cookie, "conectix", 8) == 0)
+    {
+        if (_byteswap_ulong(footer.diskType) != 2)
+        {
+            VhdReader* pVhd = new VhdReader();
+            reader = pVhd;
+            return pVhd->Open(path, flags);
+        }
+
+        // Fixed VHD is the raw disk followed by the footer.
+        ImageReader* pImage = new ImageReader();
+        SharePtr<VolumeReader> image(pImage);
+        error = pImage->Open(path, direct);
+        reader = new RangeReader(image, 0, min((LONGLONG)_byteswap_uint64(footer.currentSize), fileSize - (LONGLONG)sizeof(footer)));
+        return error;
+    }
+
+    if (IsSplitName(path))
+    {
+        SplitImageReader* pSplit = new SplitImageReader();
+        reader = pSplit;
+        return pSplit->Open(path, flags);
+    }
+
+    ImageReader* pImage = new ImageReader();
+    reader = pImage;
+    return pImage->Open(path, direct);
+}
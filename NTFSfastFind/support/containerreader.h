@@ -0,0 +1,113 @@
+// ------------------------------------------------------------------------------------------------
+// Virtual disk container readers (VHD, VHDX, split raw segments).
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+#include "VolumeReader.h"
+
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Open image file as a flat volume source, the container format is detected from its 
+// signature or name:
+//      VHD  fixed or dynamic       disk.vhd
+//      VHDX fixed or dynamic       disk.vhdx
+//      split raw segments          disk.001 (then disk.002, disk.003 ...)
+//      raw image                   anything else, see ImageReader
+// Direct reads bypass the system cache.
+// Return 0 on success, else last error.
+extern DWORD OpenImageReader(const wchar_t* path, bool direct, SharePtr<VolumeReader>& reader);
+
+// ------------------------------------------------------------------------------------------------
+// Virtual disk stored as fixed size blocks located through a block allocation table (BAT).
+// The whole table is kept in memory, 4 to 8 bytes per block (2MB to 256MB blocks), so 
+// translating an offset needs no I/O. Unallocated blocks read as zeros.
+class BlockMapReader : public VolumeReader
+{
+public:
+    BlockMapReader() :
+        m_size(0), m_blockSize(0)
+    { }
+
+    virtual DWORD Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen);
+    virtual LONGLONG Size() const
+    { return m_size; }
+
+protected:
+    static const LONGLONG sUnallocated = -1;
+
+    HandleReader            m_file;
+    LONGLONG                m_size;         // Virtual disk size.
+    DWORD                   m_blockSize;
+    std::vector<LONGLONG>   m_blockMap;     // File offset of each block's data, or sUnallocated.
+};
+
+// ------------------------------------------------------------------------------------------------
+// Dynamic VHD, differencing disks are not supported (fixed VHD is a raw image plus footer).
+class VhdReader : public BlockMapReader
+{
+public:
+    // Return 0 on success, else last error.
+    DWORD Open(const wchar_t* path, DWORD flags);
+};
+
+// ------------------------------------------------------------------------------------------------
+// VHDX, fixed or dynamic. Differencing disks and images with an unreplayed log are 
+// not supported.
+class VhdxReader : public BlockMapReader
+{
+public:
+    // Return 0 on success, else last error.
+    DWORD Open(const wchar_t* path, DWORD flags);
+};
+
+// ------------------------------------------------------------------------------------------------
+// Raw image split into numbered segments, ex: disk.001, disk.002 ...
+class SplitImageReader : public VolumeReader
+{
+public:
+    SplitImageReader() :
+        m_size(0)
+    { }
+
+    // Open first segment (name ends in digits) and all following segments.
+    // Return 0 on success, else last error.
+    DWORD Open(const wchar_t* firstPath, DWORD flags);
+
+    virtual DWORD Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen);
+    virtual LONGLONG Size() const
+    { return m_size; }
+
+private:
+    std::vector<SharePtr<HandleReader>> m_segments;
+    std::vector<LONGLONG>   m_segmentEnd;   // Offset just past each segment.
+    LONGLONG                m_size;
+};
@@ -43,17 +43,31 @@ class MatchInfo {
 public:
     const void* pMFTRecord; //  MFTRecord* (file and its attributes)
     const void* pDirectory; //  NtfsUtil::FileInfo*  (directory)
+    const void* pCatalog;   //  FileCatalog* (file is row of catalog)
+    size_t      row;
 
     MatchInfo(const void* _pMFTRecord)
         : pMFTRecord(_pMFTRecord)
         , pDirectory(NULL)
+        , pCatalog(NULL)
+        , row(0)
     {
     }
     MatchInfo(const void* _pMFTRecord, const void* _pDirectory)
         : pMFTRecord(NULL)
         , pDirectory(_pDirectory)
+        , pCatalog(NULL)
+        , row(0)
     {
     }
+
+    static MatchInfo CatalogRow(const void* _pCatalog, size_t _row)
+    {
+        MatchInfo matchInfo(NULL);
+        matchInfo.pCatalog = _pCatalog;
+        matchInfo.row = _row;
+        return matchInfo;
+    }
 };
 
 
@@ -76,6 +90,11 @@ public:
     { }
 
     virtual bool IsMatch(const MFT_STANDARD& attr, const MFT_FILEINFO& fileInfo, const MatchInfo& matchInfo) const = 0;
+
+    // Return false if IsMatch updates state (ex: counters) and can not be called by several threads.
+    virtual bool IsThreadSafe() const
+    { return true; }
+
     bool m_matchOn;
 };
 
@@ -187,6 +206,16 @@ public:
     {
         return m_testList;
     }
+
+    virtual bool IsThreadSafe() const
+    {
+        for (unsigned mIdx = 0; mIdx < m_testList.size(); mIdx++)
+        {
+            if (!m_testList[mIdx]->IsThreadSafe())
+                return false;
+        }
+        return true;
+    }
     
 protected:
     MatchList m_testList;
@@ -237,6 +266,9 @@ public:
     virtual bool IsValid() const
     { return !m_rMatch.IsNull();  }
 
+    virtual bool IsThreadSafe() const
+    { return m_rMatch.IsNull() || m_rMatch->IsThreadSafe(); }
+
 private:
     SharePtr<Match> m_rMatch;
 
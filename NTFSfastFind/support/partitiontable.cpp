@@ -0,0 +1,238 @@
+// ------------------------------------------------------------------------------------------------
+// Partition table (MBR, extended and GPT) parser for whole disk images.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "PartitionTable.h"
+
+#pragma pack(push, curAlignment)
+#pragma pack(1)
+
+// GUID partition table header, at LBA 1.
+struct GPT_HEADER
+{
+    char        signature[8];       // "EFI PART"
+    DWORD       revision;
+    DWORD       headerSize;
+    DWORD       headerCrc;
+    DWORD       reserved;
+    ULONGLONG   currentLBA;
+    ULONGLONG   backupLBA;
+    ULONGLONG   firstUsableLBA;
+    ULONGLONG   lastUsableLBA;
+    BYTE        diskGuid[16];
+    ULONGLONG   entriesLBA;
+    DWORD       entryCount;
+    DWORD       entrySize;          // 128 or larger multiple of 8.
+    DWORD       entriesCrc;
+};
+
+struct GPT_ENTRY
+{
+    BYTE        typeGuid[16];       // All zero if entry is unused.
+    BYTE        partGuid[16];
+    ULONGLONG   firstLBA;
+    ULONGLONG   lastLBA;            // Inclusive.
+    ULONGLONG   attributes;
+    WORD        name[36];           // UTF-16
+};
+#pragma pack(pop, curAlignment)
+
+static const BYTE PART_GPT_PROTECTIVE = 0xEE;
+static const BYTE PART_EXTENDED_LINUX = 0x85;
+static const unsigned sMaxLogical = 128;        // Guard against EBR chain loops.
+static const unsigned sMaxGptEntries = 1024;
+
+// ------------------------------------------------------------------------------------------------
+static bool IsExtended(BYTE chType)
+{
+    return chType == PART_EXTENDED || chType == PART_DOSX13X || chType == PART_EXTENDED_LINUX;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Read whole sector, return 0 on success, else last error.
+static DWORD ReadSector(VolumeReader& reader, LONGLONG offset, BYTE* pSector, DWORD sectorSize)
+{
+    DWORD dwBytes = 0;
+    DWORD error = reader.Read(offset, pSector, sectorSize, dwBytes);
+    if (error == ERROR_SUCCESS && dwBytes != sectorSize)
+        error = ERROR_HANDLE_EOF;
+    return error;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool PartitionTable::IsNtfsVolume(VolumeReader& reader, LONGLONG offset)
+{
+    BYTE sector[SECTOR_SIZE];
+    return ReadSector(reader, offset, sector, SECTOR_SIZE) == ERROR_SUCCESS
+        && memcmp(sector + 3, "NTFS    ", 8) == 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+static void AddPartition(
+    VolumeReader& reader, 
+    const Partition& partition, 
+    DWORD dwRelativeSector, 
+    unsigned number, 
+    PartitionTable::PartitionList& partitions)
+{
+    PartitionTable::DiskPartition diskPart;
+    ZeroMemory(&diskPart.diskInfo, sizeof(diskPart.diskInfo));
+    diskPart.diskInfo.wCylinder = partition.chCylinder;
+    diskPart.diskInfo.wHead = partition.chHead;
+    diskPart.diskInfo.wSector = partition.chSector;
+    diskPart.diskInfo.dwNumSectors = partition.dwNumberSectors;
+    diskPart.diskInfo.wType = BOOT_RECORD;
+    diskPart.diskInfo.dwRelativeSector = partition.dwRelativeSector;
+    diskPart.diskInfo.dwNTRelativeSector = dwRelativeSector;
+    diskPart.diskInfo.dwBytesPerSector = SECTOR_SIZE;
+    diskPart.chType = partition.chType;
+    diskPart.number = number;
+    diskPart.offset = (LONGLONG)dwRelativeSector * SECTOR_SIZE;
+    diskPart.length = (LONGLONG)partition.dwNumberSectors * SECTOR_SIZE;
+    diskPart.isNtfs = PartitionTable::IsNtfsVolume(reader, diskPart.offset);
+    partitions.push_back(diskPart);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Follow chain of extended boot records, each holds one logical partition (relative to the
+// EBR) and a link to the next EBR (relative to the start of the extended partition).
+static DWORD ReadExtended(VolumeReader& reader, DWORD extendedStart, PartitionTable::PartitionList& partitions)
+{
+    BYTE sector[SECTOR_SIZE];
+    DWORD ebrSector = extendedStart;
+    for (unsigned logical = 0; logical < sMaxLogical; logical++)
+    {
+        DWORD error = ReadSector(reader, (LONGLONG)ebrSector * SECTOR_SIZE, sector, SECTOR_SIZE);
+        if (error != ERROR_SUCCESS)
+            return error;
+        if (sector[510] != 0x55 || sector[511] != 0xAA)
+            return ERROR_INVALID_DATA;
+
+        const Partition* pPartition = (const Partition*)(sector + 0x1BE);
+        if (pPartition[0].chType != PART_UNKNOWN && pPartition[0].dwNumberSectors != 0)
+            AddPartition(reader, pPartition[0], ebrSector + pPartition[0].dwRelativeSector, 5 + logical, partitions);
+
+        if (!IsExtended(pPartition[1].chType) || pPartition[1].dwRelativeSector == 0)
+            return ERROR_SUCCESS;
+        ebrSector = extendedStart + pPartition[1].dwRelativeSector;
+    }
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+// GPT header is in the second logical sector, try 512 byte then 4K sectors.
+static DWORD ReadGpt(VolumeReader& reader, PartitionTable::PartitionList& partitions)
+{
+    static const DWORD sSectorSizes[] = { 512, 4096 };
+    Buffer sector;
+    sector.resize(4096);
+
+    for (unsigned sizeIdx = 0; sizeIdx < ARRAYSIZE(sSectorSizes); sizeIdx++)
+    {
+        DWORD sectorSize = sSectorSizes[sizeIdx];
+        DWORD error = ReadSector(reader, sectorSize, sector.Data(), sectorSize);
+        if (error != ERROR_SUCCESS)
+            return error;
+
+        const GPT_HEADER* pHeader = (const GPT_HEADER*)sector.Data();
+        if (memcmp(pHeader->signature, "EFI PART", 8) != 0)
+            continue;
+        if (pHeader->entrySize < sizeof(GPT_ENTRY) || pHeader->entrySize % 8 != 0)
+            return ERROR_INVALID_DATA;
+
+        DWORD entryCount = min(pHeader->entryCount, (DWORD)sMaxGptEntries);
+        DWORD entrySize = pHeader->entrySize;
+        Buffer entries;
+        entries.resize((size_t)entryCount * entrySize);
+        DWORD dwBytes = 0;
+        error = reader.Read((LONGLONG)pHeader->entriesLBA * sectorSize, entries.Data(), (DWORD)entries.size(), dwBytes);
+        if (error != ERROR_SUCCESS)
+            return error;
+
+        static const BYTE sUnused[16] = { 0 };
+        for (DWORD entryIdx = 0; (entryIdx + 1) * entrySize <= dwBytes; entryIdx++)
+        {
+            const GPT_ENTRY* pEntry = (const GPT_ENTRY*)(entries.Data() + entryIdx * entrySize);
+            if (memcmp(pEntry->typeGuid, sUnused, sizeof(sUnused)) == 0 || pEntry->lastLBA < pEntry->firstLBA)
+                continue;
+
+            PartitionTable::DiskPartition diskPart;
+            ZeroMemory(&diskPart.diskInfo, sizeof(diskPart.diskInfo));
+            // 32 bit sector fields wrap past 2 TB, they are left 0, use offset and length.
+            diskPart.diskInfo.wType = BOOT_RECORD;
+            diskPart.diskInfo.dwBytesPerSector = sectorSize;
+            diskPart.chType = PART_UNKNOWN;
+            diskPart.number = entryIdx + 1;
+            diskPart.offset = (LONGLONG)pEntry->firstLBA * sectorSize;
+            diskPart.length = (LONGLONG)(pEntry->lastLBA - pEntry->firstLBA + 1) * sectorSize;
+            diskPart.isNtfs = PartitionTable::IsNtfsVolume(reader, diskPart.offset);
+            partitions.push_back(diskPart);
+        }
+        return ERROR_SUCCESS;
+    }
+
+    return ERROR_NOT_FOUND;
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD PartitionTable::Read(VolumeReader& reader, PartitionList& partitions)
+{
+    partitions.clear();
+
+    BYTE mbr[SECTOR_SIZE];
+    DWORD error = ReadSector(reader, 0, mbr, SECTOR_SIZE);
+    if (error != ERROR_SUCCESS)
+        return error;
+    if (mbr[510] != 0x55 || mbr[511] != 0xAA || memcmp(mbr + 3, "NTFS    ", 8) == 0)
+        return ERROR_NOT_FOUND;     // Not a disk, or an unpartitioned NTFS volume.
+
+    const Partition* pPartition = (const Partition*)(mbr + 0x1BE);
+    for (unsigned partIdx = 0; partIdx < 4; partIdx++)
+    {
+        if (pPartition[partIdx].chType == PART_GPT_PROTECTIVE)
+            return ReadGpt(reader, partitions);
+    }
+
+    for (unsigned partIdx = 0; partIdx < 4; partIdx++)
+    {
+        const Partition& partition = pPartition[partIdx];
+        if (partition.chType == PART_UNKNOWN || partition.dwNumberSectors == 0)
+            continue;
+
+        if (IsExtended(partition.chType))
+        {
+            // Damaged logical partitions do not hide the primary ones.
+            ReadExtended(reader, partition.dwRelativeSector, partitions);
+            continue;
+        }
+        AddPartition(reader, partition, partition.dwRelativeSector, partIdx + 1, partitions);
+    }
+
+    return partitions.empty() ? ERROR_NOT_FOUND : ERROR_SUCCESS;
+}
@@ -0,0 +1,68 @@
+// ------------------------------------------------------------------------------------------------
+// Partition table (MBR, extended and GPT) parser for whole disk images.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+#include "FsUtil.h"
+#include "VolumeReader.h"
+
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Locate partitions of a whole disk image without Windows disk IOCTLs, so images can be 
+// scanned on any host. NTFS partitions are found by their boot sector OEM ID.
+//
+//  Ex:
+//      PartitionTable::PartitionList partitions;
+//      if (PartitionTable::Read(*reader, partitions) == ERROR_SUCCESS)
+//          for each partitions[idx].isNtfs 
+//              new RangeReader(reader, partitions[idx].offset, partitions[idx].length)
+
+namespace PartitionTable
+{
+    struct DiskPartition
+    {
+        DiskInfo    diskInfo;       // Sector values are 0 for GPT partitions, see offset and length.
+        BYTE        chType;         // MBR partition type (ex: PART_NTFS), PART_UNKNOWN for GPT.
+        unsigned    number;         // 1 based, MBR primary 1..4, logical 5.., or GPT entry.
+        LONGLONG    offset;         // Byte offset of partition in disk.
+        LONGLONG    length;         // Bytes.
+        bool        isNtfs;         // Boot sector OEM ID is "NTFS".
+    };
+    typedef std::vector<DiskPartition> PartitionList;
+
+    // Return true if sector 0 is an NTFS boot sector, source is a volume not a disk.
+    bool IsNtfsVolume(VolumeReader& reader, LONGLONG offset = 0);
+
+    // Read MBR (and its extended partitions) or GPT of whole disk.
+    // Return 0 on success, ERROR_NOT_FOUND if there is no partition table, else last error.
+    DWORD Read(VolumeReader& reader, PartitionList& partitions);
+};
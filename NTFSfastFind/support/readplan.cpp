@@ -0,0 +1,186 @@
+// ------------------------------------------------------------------------------------------------
+// Read planner, coalesce and sort extent reads by disk position.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "ReadPlan.h"
+#include "AsyncReader.h"
+
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+struct ExtentPosLess
+{
+    ExtentPosLess(const ReadPlan::ExtentList& extents) : m_extents(extents)
+    { }
+
+    bool operator()(size_t lhs, size_t rhs) const
+    { return m_extents[lhs].pos < m_extents[rhs].pos; }
+
+    const ReadPlan::ExtentList& m_extents;
+};
+
+// ------------------------------------------------------------------------------------------------
+void ReadPlan::Build(const ExtentList& extents)
+{
+    m_requests.clear();
+    m_gapBytes = 0;
+
+    std::vector<size_t> order(extents.size());
+    for (size_t extentIdx = 0; extentIdx < extents.size(); extentIdx++)
+        order[extentIdx] = extentIdx;
+    if (m_sortByPos)
+        std::stable_sort(order.begin(), order.end(), ExtentPosLess(extents));
+
+    for (size_t orderIdx = 0; orderIdx < order.size(); orderIdx++)
+    {
+        const Extent& extent = extents[order[orderIdx]];
+        if (extent.len == 0)
+            continue;
+
+        Piece piece;
+        piece.extentIdx = order[orderIdx];
+
+        if (!m_requests.empty())
+        {
+            // Merge if extent starts at or shortly after end of previous request.
+            Request& request = m_requests.back();
+            LONGLONG reqEnd = request.pos + request.len;
+            if (extent.pos >= reqEnd 
+                && extent.pos - reqEnd <= m_maxGap
+                && extent.pos + extent.len - request.pos <= m_maxRequest)
+            {
+                m_gapBytes += extent.pos - reqEnd;
+                piece.offset = (DWORD)(extent.pos - request.pos);
+                request.len  = (DWORD)(extent.pos + extent.len - request.pos);
+                request.pieces.push_back(piece);
+                continue;
+            }
+        }
+
+        Request request;
+        request.pos = extent.pos;
+        request.len = extent.len;
+        piece.offset = 0;
+        request.pieces.push_back(piece);
+        m_requests.push_back(request);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD ReadPlan::MaxLength() const
+{
+    DWORD maxLen = 0;
+    for (unsigned reqIdx = 0; reqIdx < m_requests.size(); reqIdx++)
+        maxLen = max(maxLen, m_requests[reqIdx].len);
+    return maxLen;
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD ReadPlan::ReadRequest(VolumeReader& reader, const Request& request, BYTE* pDst, DWORD& outLen)
+{
+    outLen = 0;
+    while (outLen < request.len)
+    {
+        DWORD dwBytes = 0;
+        DWORD error = reader.Read(request.pos + outLen, pDst + outLen, request.len - outLen, dwBytes);
+        if (error != ERROR_SUCCESS)
+            return error;
+        if (dwBytes == 0)
+            break;      // end of source
+        outLen += dwBytes;
+    }
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD ReadPlan::ReadAll(VolumeReader& reader, const ExtentList& extents, Buffer& outBuffer, 
+    DWORD maxRequest, DWORD maxGap, unsigned queueDepth)
+{
+    // Logical offset of each extent in outBuffer.
+    size_t begSize = outBuffer.size();
+    std::vector<size_t> outOffsets(extents.size());
+    size_t outSize = begSize;
+    for (size_t extentIdx = 0; extentIdx < extents.size(); extentIdx++)
+    {
+        outOffsets[extentIdx] = outSize;
+        outSize += extents[extentIdx].len;
+    }
+    outBuffer.resize(outSize);
+
+    ReadPlan readPlan(maxRequest, maxGap);
+    readPlan.Build(extents);
+    const RequestList& requests = readPlan.Requests();
+
+    // Single extent is read in place, merged extents are scattered from a request buffer.
+    // Completions arrive in submit order, so request buffers are reused round robin.
+    AsyncReader asyncReader(reader, (unsigned)min((size_t)queueDepth, max(requests.size(), (size_t)1)));
+    std::vector<AlignedBuffer> reqBuffers(asyncReader.QueueDepth());
+
+    size_t nextReq = 0;
+    DWORD error = ERROR_SUCCESS;
+    while (error == ERROR_SUCCESS && (nextReq < requests.size() || asyncReader.Pending() != 0))
+    {
+        if (nextReq < requests.size() && !asyncReader.IsFull())
+        {
+            const Request& request = requests[nextReq];
+            BYTE* pDst;
+            if (request.pieces.size() == 1)
+                pDst = outBuffer.Data() + outOffsets[request.pieces[0].extentIdx];
+            else
+            {
+                AlignedBuffer& reqBuffer = reqBuffers[nextReq % reqBuffers.size()];
+                reqBuffer.resize(request.len);
+                pDst = reqBuffer.Data();
+            }
+            error = asyncReader.Submit(request.pos, pDst, request.len, nextReq++);
+            continue;
+        }
+
+        AsyncReader::Completion done;
+        error = asyncReader.Wait(done);
+        const Request& request = requests[done.tag];
+        if (error == ERROR_SUCCESS && done.outLen != request.len)
+            error = ERROR_HANDLE_EOF;
+        if (error != ERROR_SUCCESS)
+            break;
+
+        for (unsigned pieceIdx = 0; request.pieces.size() > 1 && pieceIdx < request.pieces.size(); pieceIdx++)
+        {
+            const Piece& piece = request.pieces[pieceIdx];
+            memcpy(outBuffer.Data() + outOffsets[piece.extentIdx], done.pDst + piece.offset, extents[piece.extentIdx].len);
+        }
+    }
+
+    if (error != ERROR_SUCCESS)
+    {
+        asyncReader.Drain();
+        outBuffer.resize(begSize);
+    }
+    return error;
+}
@@ -0,0 +1,110 @@
+// ------------------------------------------------------------------------------------------------
+// Read planner, coalesce and sort extent reads by disk position.
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+#include "VolumeReader.h"
+
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Plan reads of a list of extents (ex: file data runs), given in logical (VCN) order.
+// Adjacent and near adjacent extents are merged into one request, the gap between them is
+// read and discarded. Requests are issued in disk position order, each request lists the
+// extents (pieces) it holds so the data can be scattered back into logical order.
+//
+//  Ex:
+//      ReadPlan readPlan(4 << 20, 64 << 10);
+//      readPlan.Build(extents);
+//      for (unsigned reqIdx = 0; reqIdx < readPlan.Requests().size(); reqIdx++)
+//          ... read request, copy each piece to extent's logical offset.
+
+class ReadPlan
+{
+public:
+    struct Extent
+    {
+        LONGLONG    pos;            // Absolute byte offset.
+        DWORD       len;
+    };
+    typedef std::vector<Extent> ExtentList;
+
+    struct Piece
+    {
+        size_t      extentIdx;      // Index in extent list given to Build.
+        DWORD       offset;         // Offset of extent in request.
+    };
+
+    struct Request
+    {
+        LONGLONG            pos;
+        DWORD               len;
+        std::vector<Piece>  pieces;
+    };
+    typedef std::vector<Request> RequestList;
+
+    // maxRequest - largest merged read, a single larger extent is read as is.
+    // maxGap     - largest hole to read over when merging extents.
+    // sortByPos  - issue requests in disk order, else keep extent order and only merge
+    //              extents which follow each other.
+    ReadPlan(DWORD maxRequest, DWORD maxGap, bool sortByPos = true) :
+        m_maxRequest(maxRequest), m_maxGap(maxGap), m_sortByPos(sortByPos), m_gapBytes(0)
+    { }
+
+    void Build(const ExtentList& extents);
+
+    const RequestList& Requests() const
+    { return m_requests; }
+
+    // Largest request length.
+    DWORD MaxLength() const;
+
+    // Bytes read over gaps between merged extents.
+    LONGLONG GapBytes() const
+    { return m_gapBytes; }
+
+    // Read extents and append them to outBuffer in logical order, keeping up to 
+    // queueDepth requests in flight.
+    // Return 0 on success, else last error.
+    static DWORD ReadAll(VolumeReader& reader, const ExtentList& extents, Buffer& outBuffer, 
+        DWORD maxRequest, DWORD maxGap, unsigned queueDepth = 1);
+
+    // Read request, outLen is less than request length at end of source.
+    // Return 0 on success, else last error.
+    static DWORD ReadRequest(VolumeReader& reader, const Request& request, BYTE* pDst, DWORD& outLen);
+
+private:
+    DWORD       m_maxRequest;
+    DWORD       m_maxGap;
+    bool        m_sortByPos;
+    LONGLONG    m_gapBytes;
+    RequestList m_requests;
+};
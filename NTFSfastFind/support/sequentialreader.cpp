@@ -0,0 +1,199 @@
+// ------------------------------------------------------------------------------------------------
+// Forward only volume source, reads image front to back once (HDD archive, pipe or stdin).
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "SequentialReader.h"
+
+// ------------------------------------------------------------------------------------------------
+DWORD SequentialReader::Open(const wchar_t* path)
+{
+    if (wcscmp(path, L"-") == 0)
+    {
+        // Own a copy of the stdin handle, Hnd closes it.
+        HANDLE stdinHnd;
+        if (!DuplicateHandle(GetCurrentProcess(), GetStdHandle(STD_INPUT_HANDLE), 
+                GetCurrentProcess(), &stdinHnd, 0, FALSE, DUPLICATE_SAME_ACCESS))
+            return GetLastError();
+        m_hnd = stdinHnd;
+    }
+    else
+    {
+        m_hnd = CreateFile(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0, OPEN_EXISTING, 
+            FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (!m_hnd.IsValid())
+            return GetLastError();
+    }
+
+    m_seekable = (GetFileType(m_hnd) == FILE_TYPE_DISK);
+    LARGE_INTEGER size;
+    if (m_seekable && GetFileSizeEx(m_hnd, &size))
+        m_size = size.QuadPart;
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+void SequentialReader::Retain(LONGLONG offset, LONGLONG len)
+{
+    if (len <= 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    std::vector<Kept>::iterator iter = m_kept.begin();
+    while (iter != m_kept.end() && iter->pos <= offset)
+        ++iter;
+
+    iter = m_kept.insert(iter, Kept());
+    iter->pos = offset;
+    iter->validPos = max(offset, m_blockPos);
+    iter->data.resize((size_t)len);
+    Keep(*iter);    // Part of region in current block.
+}
+
+// ------------------------------------------------------------------------------------------------
+// Copy part of current block which falls in retained region.
+void SequentialReader::Keep(Kept& kept)
+{
+    LONGLONG startPos = max(kept.pos, m_blockPos);
+    LONGLONG endPos = min(kept.pos + (LONGLONG)kept.data.size(), StreamEnd());
+    if (startPos < endPos)
+        memcpy(kept.data.Data() + (startPos - kept.pos), m_block.Data() + (startPos - m_blockPos), (size_t)(endPos - startPos));
+}
+
+// ------------------------------------------------------------------------------------------------
+// Return true if any retained region overlaps [pos, endPos).
+bool SequentialReader::IsRetained(LONGLONG pos, LONGLONG endPos) const
+{
+    for (unsigned keptIdx = 0; keptIdx < m_kept.size(); keptIdx++)
+    {
+        const Kept& kept = m_kept[keptIdx];
+        if (kept.pos < endPos && kept.pos + (LONGLONG)kept.data.size() > pos)
+            return true;
+    }
+    return false;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Replace current block with the next one, skip ahead to targetPos if nothing before it
+// is retained and the source can seek.
+// Return 0 on success (m_block is empty at end of source), else last error.
+DWORD SequentialReader::NextBlock(LONGLONG targetPos)
+{
+    LONGLONG streamEnd = StreamEnd();
+    if (m_seekable && targetPos > streamEnd && !IsRetained(streamEnd, targetPos))
+    {
+        LARGE_INTEGER move;
+        move.QuadPart = targetPos - streamEnd;
+        if (SetFilePointerEx(m_hnd, move, NULL, FILE_CURRENT))
+        {
+            m_bytesSkipped += targetPos - streamEnd;
+            streamEnd = targetPos;
+        }
+    }
+
+    // Pipes return partial reads, fill whole block unless at end of source.
+    m_blockPos = streamEnd;
+    m_block.resize(m_blockSize);
+    DWORD filled = 0;
+    while (filled < m_blockSize)
+    {
+        DWORD dwBytes = 0;
+        if (!ReadFile(m_hnd, m_block.Data() + filled, m_blockSize - filled, &dwBytes, NULL))
+        {
+            DWORD error = GetLastError();
+            if (error != ERROR_BROKEN_PIPE && error != ERROR_HANDLE_EOF)
+            {
+                m_block.clear();
+                return error;
+            }
+            dwBytes = 0;
+        }
+        if (dwBytes == 0)
+        {
+            m_eof = true;
+            break;
+        }
+        filled += dwBytes;
+    }
+    m_block.resize(filled);
+    m_bytesRead += filled;
+
+    for (unsigned keptIdx = 0; keptIdx < m_kept.size(); keptIdx++)
+        Keep(m_kept[keptIdx]);
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD SequentialReader::Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    BYTE* pOut = (BYTE*)pDst;
+    outLen = 0;
+    while (outLen < len)
+    {
+        LONGLONG pos = offset + outLen;
+        DWORD remaining = len - outLen;
+
+        // Retained copy, valid up to end of stream read so far.
+        const Kept* pKept = NULL;
+        for (unsigned keptIdx = 0; keptIdx < m_kept.size() && pKept == NULL; keptIdx++)
+        {
+            const Kept& kept = m_kept[keptIdx];
+            if (pos >= kept.validPos && pos < kept.pos + (LONGLONG)kept.data.size() && pos < StreamEnd())
+                pKept = &kept;
+        }
+
+        DWORD pieceLen;
+        if (pKept != NULL)
+        {
+            LONGLONG endPos = min(pKept->pos + (LONGLONG)pKept->data.size(), StreamEnd());
+            pieceLen = (DWORD)min((LONGLONG)remaining, endPos - pos);
+            memcpy(pOut + outLen, pKept->data.Data() + (pos - pKept->pos), pieceLen);
+        }
+        else if (pos >= m_blockPos && pos < StreamEnd())
+        {
+            pieceLen = (DWORD)min((LONGLONG)remaining, StreamEnd() - pos);
+            memcpy(pOut + outLen, m_block.Data() + (pos - m_blockPos), pieceLen);
+        }
+        else if (pos >= StreamEnd())
+        {
+            if (m_eof)
+                break;      // end of source.
+            DWORD error = NextBlock(pos);
+            if (error != ERROR_SUCCESS)
+                return error;
+            continue;
+        }
+        else
+        {
+            return ERROR_SEEK;  // Passed and not retained.
+        }
+        outLen += pieceLen;
+    }
+    return ERROR_SUCCESS;
+}
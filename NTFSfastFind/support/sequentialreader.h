@@ -0,0 +1,108 @@
+// ------------------------------------------------------------------------------------------------
+// Forward only volume source, reads image front to back once (HDD archive, pipe or stdin).
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BaseTypes.h"
+#include "VolumeReader.h"
+
+#include <mutex>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Read image strictly front to back in large blocks, for sources where seeks are slow 
+// (HDD archive, network share) or impossible (pipe, stdin).
+//
+// Reads must be issued in increasing offset order, bytes between reads are skipped (seek if
+// the source allows it, else read and discarded). Regions marked with Retain are copied as 
+// the stream passes them, so they can be read again in any order (ex: MFT records read to
+// build directories). Reading behind the current block anything else fails with ERROR_SEEK.
+//
+//  Ex:
+//      SequentialReader* pStream = new SequentialReader();
+//      SharePtr<VolumeReader> reader(pStream);
+//      if (pStream->Open(L"-") == ERROR_SUCCESS)   // stdin
+//          ntfsUtil.SetReader(reader);
+
+class SequentialReader : public VolumeReader
+{
+public:
+    SequentialReader(DWORD blockSize = sDefaultBlockSize) :
+        m_blockSize(blockSize), m_seekable(false), m_eof(false), m_blockPos(0), m_size(0),
+        m_bytesRead(0), m_bytesSkipped(0)
+    { }
+
+    // Open image file, or standard input if path is "-".
+    // Return 0 on success, else last error.
+    DWORD Open(const wchar_t* path);
+
+    virtual DWORD Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen);
+    virtual LONGLONG Size() const
+    { return m_size; }
+
+    // Keep a copy of region as it is read, memory use is the sum of retained regions
+    // plus one block. Parts of the region already passed are lost.
+    virtual void Retain(LONGLONG offset, LONGLONG len);
+
+    LONGLONG BytesRead() const
+    { return m_bytesRead; }
+    LONGLONG BytesSkipped() const
+    { return m_bytesSkipped; }
+
+    static const DWORD sDefaultBlockSize = 8 << 20;
+
+private:
+    struct Kept
+    {
+        LONGLONG    pos;
+        LONGLONG    validPos;       // Data before this was passed before region was retained.
+        Buffer      data;
+    };
+
+    LONGLONG StreamEnd() const
+    { return m_blockPos + (LONGLONG)m_block.size(); }
+
+    DWORD NextBlock(LONGLONG targetPos);
+    bool  IsRetained(LONGLONG pos, LONGLONG endPos) const;
+    void  Keep(Kept& kept);
+
+    Hnd         m_hnd;
+    DWORD       m_blockSize;
+    bool        m_seekable;         // File on disk, skip by moving file pointer.
+    bool        m_eof;
+    Buffer      m_block;            // Most recent block.
+    LONGLONG    m_blockPos;         // Offset of m_block in source.
+    LONGLONG    m_size;             // 0 if unknown (pipe).
+    std::vector<Kept> m_kept;       // Sorted by pos.
+    std::mutex  m_lock;
+
+    LONGLONG    m_bytesRead;
+    LONGLONG    m_bytesSkipped;     // Seeked over without reading.
+};
@@ -7,9 +7,12 @@
 
 #pragma once
 
+#include <Windows.h>
 #include <assert.h>
 
 /// Simple smart pointer with reference counting.
+/// Reference count is atomic so copies can be shared by threads scanning several volumes,
+/// the item itself is not protected.
 template < typename T > 
 class SharePtr
 {
@@ -30,23 +33,16 @@ public:
     {
         if (this != &rhs)
         {
-            m_pShareItem = rhs.m_pShareItem != NULL ? rhs.m_pShareItem->Add() : NULL;
+            ShareItem* pShareItem = rhs.m_pShareItem != NULL ? rhs.m_pShareItem->Add() : NULL;
+            Release();
+            m_pShareItem = pShareItem;
         }
         return *this;
     }
 
     ~SharePtr() 
     {
-        if (m_pShareItem != NULL)
-        {
-            int refCnt = m_pShareItem->Dec();
-            assert(refCnt >= 0);
-
-            if (0 == refCnt)
-            {
-                delete m_pShareItem;
-            }
-        }
+        Release();
     }
 
     class ShareItem
@@ -66,13 +62,13 @@ public:
         }
 
         ShareItem* Add() 
-        { m_refCnt++; return this; }    // not thread safe
+        { InterlockedIncrement(&m_refCnt); return this; }
 
         int Dec() 
-        { return --m_refCnt; }          // not thread safe
+        { return (int)InterlockedDecrement(&m_refCnt); }
 
         T*          m_pItem;
-        mutable int m_refCnt;
+        volatile LONG m_refCnt;
         int         m_marker;
     };
 
@@ -90,6 +86,21 @@ public:
     {  return m_pShareItem->m_pItem; }
 
 private:
+    void Release()
+    {
+        if (m_pShareItem != NULL)
+        {
+            int refCnt = m_pShareItem->Dec();
+            assert(refCnt >= 0);
+
+            if (0 == refCnt)
+            {
+                delete m_pShareItem;
+            }
+            m_pShareItem = NULL;
+        }
+    }
+
     ShareItem*  m_pShareItem;
 };
 
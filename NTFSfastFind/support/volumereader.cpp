@@ -0,0 +1,183 @@
+// ------------------------------------------------------------------------------------------------
+// Volume reader classes, source of raw NTFS volume bytes (live volume or image file).
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#include "VolumeReader.h"
+
+// ------------------------------------------------------------------------------------------------
+DWORD HandleReader::Open(const wchar_t* path, DWORD flags)
+{
+    m_hnd = CreateFile(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0, OPEN_EXISTING, flags, NULL);
+    if (!m_hnd.IsValid())
+        return GetLastError();
+
+    // Optional second handle for queued reads, AsyncReader falls back to threads without it.
+    m_asyncHnd = CreateFile(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0, OPEN_EXISTING, 
+        flags | FILE_FLAG_OVERLAPPED, NULL);
+
+    m_align = ((flags & FILE_FLAG_NO_BUFFERING) != 0) ? sMaxSectorSize : 1;
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+void HandleReader::SetSectorSize(DWORD bytesPerSector)
+{
+    // Must be a power of 2, else keep the largest sector size.
+    if (m_align > 1 && bytesPerSector >= 512 && bytesPerSector <= sMaxSectorSize 
+        && (bytesPerSector & (bytesPerSector - 1)) == 0)
+        m_align = bytesPerSector;
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD HandleReader::Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen)
+{
+    if (m_align > 1 
+        && ((offset | len | (ULONG_PTR)pDst) & (m_align - 1)) != 0)
+        return ReadPadded(offset, pDst, len, outLen);
+    return ReadFileAt(offset, pDst, len, outLen);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Unbuffered read of whole sectors into an aligned buffer, copy requested part to pDst.
+DWORD HandleReader::ReadPadded(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen)
+{
+    LONGLONG alignedPos = offset & ~(LONGLONG)(m_align - 1);
+    DWORD head = (DWORD)(offset - alignedPos);
+    DWORD alignedLen = (head + len + m_align - 1) & ~(m_align - 1);
+
+    AlignedBuffer* pBuffer = m_pool.Get(alignedLen);
+    DWORD dwBytes = 0;
+    DWORD error = ReadFileAt(alignedPos, pBuffer->Data(), alignedLen, dwBytes);
+    outLen = (dwBytes > head) ? min(len, dwBytes - head) : 0;
+    memcpy(pDst, pBuffer->Data() + head, outLen);
+    m_pool.Release(pBuffer);
+    return error;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Positional read, the OVERLAPPED offset is honored on a synchronous handle and
+// the call returns when the read completes.
+DWORD HandleReader::ReadFileAt(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen)
+{
+    OVERLAPPED overlapped;
+    ZeroMemory(&overlapped, sizeof(overlapped));
+    LARGE_INTEGER pos;
+    pos.QuadPart = offset;
+    overlapped.Offset = pos.LowPart;
+    overlapped.OffsetHigh = pos.HighPart;
+
+    outLen = 0;
+    if (!ReadFile(m_hnd, pDst, len, &outLen, &overlapped))
+    {
+        DWORD error = GetLastError();
+        return (error == ERROR_HANDLE_EOF) ? ERROR_SUCCESS : error;
+    }
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+LONGLONG HandleReader::Size() const
+{
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_hnd, &size))
+        return 0;       // Volume devices do not report a file size.
+    return size.QuadPart;
+}
+
+// ------------------------------------------------------------------------------------------------
+ImageReader::~ImageReader()
+{
+    if (m_pBase != NULL)
+        UnmapViewOfFile(m_pBase);
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD ImageReader::Open(const wchar_t* path, bool direct)
+{
+    DWORD error = HandleReader::Open(path, direct ? FILE_FLAG_NO_BUFFERING : FILE_FLAG_RANDOM_ACCESS);
+    if (error != ERROR_SUCCESS)
+        return error;
+
+    m_size = HandleReader::Size();
+    if (m_size == 0)
+        return ERROR_HANDLE_EOF;
+    if (direct)
+        return ERROR_SUCCESS;   // Mapped view would go through the system cache.
+
+    // Map entire image, if address space is not available keep using ReadFile.
+    HANDLE mapHnd = CreateFileMapping(m_hnd, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapHnd != NULL)
+    {
+        m_mapHnd = mapHnd;
+        if ((ULONGLONG)m_size <= (SIZE_T)-1)
+            m_pBase = (const BYTE*)MapViewOfFile(m_mapHnd, FILE_MAP_READ, 0, 0, 0);
+    }
+
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD ImageReader::Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen)
+{
+    if (m_pBase == NULL)
+        return HandleReader::Read(offset, pDst, len, outLen);
+
+    outLen = 0;
+    if (offset < 0 || offset >= m_size)
+        return ERROR_SUCCESS;   // end of file.
+
+    outLen = (DWORD)min((LONGLONG)len, m_size - offset);
+    memcpy(pDst, m_pBase + offset, outLen);
+    return ERROR_SUCCESS;
+}
+
+// ------------------------------------------------------------------------------------------------
+const BYTE* ImageReader::View(LONGLONG offset, LONGLONG len) const
+{
+    if (m_pBase == NULL || offset < 0 || len < 0 || offset + len > m_size)
+        return NULL;
+    return m_pBase + offset;
+}
+
+// ------------------------------------------------------------------------------------------------
+DWORD RangeReader::Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen)
+{
+    outLen = 0;
+    if (offset < 0 || offset >= m_length)
+        return ERROR_SUCCESS;   // end of range.
+    return m_reader->Read(m_offset + offset, pDst, (DWORD)min((LONGLONG)len, m_length - offset), outLen);
+}
+
+// ------------------------------------------------------------------------------------------------
+const BYTE* RangeReader::View(LONGLONG offset, LONGLONG len) const
+{
+    if (offset < 0 || len < 0 || offset + len > m_length)
+        return NULL;
+    return m_reader->View(m_offset + offset, len);
+}
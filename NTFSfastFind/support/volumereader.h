@@ -0,0 +1,188 @@
+// ------------------------------------------------------------------------------------------------
+// Volume reader classes, source of raw NTFS volume bytes (live volume or image file).
+//
+// Project: NTFSfastFind
+// Author:  NTFSfastFind contributors   Oct-2026
+// https://landenlabs.com
+//
+// ----- License ----
+//
+// Copyright (c) 2026 NTFSfastFind contributors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "AlignedBuffer.h"
+#include "BaseTypes.h"
+
+// ------------------------------------------------------------------------------------------------
+// Abstract source of volume bytes used by NtfsUtil and MFTRecord.
+// All offsets are absolute byte offsets from the start of the source.
+//
+//  Ex:
+//      ImageReader* pImage = new ImageReader();
+//      SharePtr<VolumeReader> reader(pImage);
+//      if (pImage->Open(L"d:\\images\\disk.dd") == ERROR_SUCCESS)
+//          ntfsUtil.SetReader(reader);
+
+class VolumeReader
+{
+public:
+    virtual ~VolumeReader()
+    { }
+
+    // Positional read, does not depend on a shared file pointer.
+    // Return 0 on success, else last error.
+    virtual DWORD Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen) = 0;
+
+    // Return pointer to 'len' bytes at 'offset' if the source can provide them without
+    // copying (memory mapped image), else NULL. Region is read only.
+    virtual const BYTE* View(LONGLONG /* offset */, LONGLONG /* len */) const
+    { return NULL; }
+
+    // Size of source in bytes, 0 if unknown (ex: raw volume device).
+    virtual LONGLONG Size() const
+    { return 0; }
+
+    // Handle opened with FILE_FLAG_OVERLAPPED to queue several reads at once, see AsyncReader.
+    // INVALID_HANDLE_VALUE if not available, reads are then issued from a thread pool.
+    virtual HANDLE OverlappedHandle() const
+    { return INVALID_HANDLE_VALUE; }
+
+    // Unbuffered (direct) sources need offset, length and buffer address aligned to this,
+    // 1 if any read is allowed. Read pads unaligned requests itself.
+    virtual DWORD Alignment() const
+    { return 1; }
+
+    // Sector size from the NTFS boot sector, used to align unbuffered reads.
+    virtual void SetSectorSize(DWORD /* bytesPerSector */)
+    { }
+
+    // Aligned buffers used to pad unaligned reads, NULL if reads need not be aligned.
+    virtual AlignedPool* BufferPool()
+    { return NULL; }
+
+    // Hint, region will be read again (ex: MFT records looked up after the scan). Forward
+    // only sources keep a copy as they pass it, see SequentialReader.
+    virtual void Retain(LONGLONG /* offset */, LONGLONG /* len */)
+    { }
+};
+
+// ------------------------------------------------------------------------------------------------
+// Read volume using a Win32 file handle, ex: \\.\C: or \\.\PhysicalDrive0
+// With FILE_FLAG_NO_BUFFERING reads bypass the system cache (direct I/O), unaligned
+// reads are padded to whole sectors using a pooled aligned buffer.
+class HandleReader : public VolumeReader
+{
+public:
+    HandleReader() :
+        m_align(1)
+    { }
+
+    // Return 0 on success, else last error.
+    DWORD Open(const wchar_t* path, DWORD flags = 0);
+
+    virtual DWORD Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen);
+    virtual LONGLONG Size() const;
+    virtual HANDLE OverlappedHandle() const
+    { return m_asyncHnd; }
+
+    virtual DWORD Alignment() const
+    { return m_align; }
+    virtual void SetSectorSize(DWORD bytesPerSector);
+    virtual AlignedPool* BufferPool()
+    { return (m_align > 1) ? &m_pool : NULL; }
+
+    // Largest sector size, used until the boot sector is read.
+    static const DWORD sMaxSectorSize = 4096;
+
+protected:
+    DWORD ReadFileAt(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen);
+    DWORD ReadPadded(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen);
+
+    Hnd         m_hnd;
+    Hnd         m_asyncHnd;     // Same path opened for overlapped reads, optional.
+    DWORD       m_align;        // Sector size if unbuffered, else 1.
+    AlignedPool m_pool;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Read raw NTFS volume image file (ex: dd image), memory mapped so the MFT can be
+// used in place without copying it.  Falls back to ReadFile if the image can not
+// be mapped (ex: 32bit process and large image).
+class ImageReader : public HandleReader
+{
+public:
+    ImageReader() :
+        m_pBase(NULL), m_size(0)
+    { }
+
+    virtual ~ImageReader();
+
+    // Return 0 on success, else last error.
+    // Direct reads bypass the system cache, the image is not mapped.
+    DWORD Open(const wchar_t* path, bool direct = false);
+
+    virtual DWORD Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen);
+    virtual const BYTE* View(LONGLONG offset, LONGLONG len) const;
+    virtual LONGLONG Size() const
+    { return m_size; }
+
+    // Mapped image is copied, queued reads use the thread pool.
+    virtual HANDLE OverlappedHandle() const
+    { return (m_pBase != NULL) ? INVALID_HANDLE_VALUE : HandleReader::OverlappedHandle(); }
+
+private:
+    Hnd         m_mapHnd;
+    const BYTE* m_pBase;        // Mapped view of entire image or NULL.
+    LONGLONG    m_size;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Byte range of another source, ex: one partition of a whole disk image.
+// Offsets are relative to start of range, reads past its end return no bytes.
+class RangeReader : public VolumeReader
+{
+public:
+    RangeReader(const SharePtr<VolumeReader>& reader, LONGLONG offset, LONGLONG length) :
+        m_reader(reader), m_offset(offset), m_length(length)
+    { }
+
+    virtual DWORD Read(LONGLONG offset, void* pDst, DWORD len, DWORD& outLen);
+    virtual const BYTE* View(LONGLONG offset, LONGLONG len) const;
+    virtual LONGLONG Size() const
+    { return m_length; }
+
+    // Overlapped reads would use offsets of the whole source, queued reads use the thread pool.
+    virtual DWORD Alignment() const
+    { return m_reader->Alignment(); }
+    virtual void SetSectorSize(DWORD bytesPerSector)
+    { m_reader->SetSectorSize(bytesPerSector); }
+    virtual AlignedPool* BufferPool()
+    { return m_reader->BufferPool(); }
+    virtual void Retain(LONGLONG offset, LONGLONG len)
+    { m_reader->Retain(m_offset + offset, len); }
+
+private:
+    SharePtr<VolumeReader> m_reader;
+    LONGLONG    m_offset;       // Start of range in m_reader.
+    LONGLONG    m_length;
+};
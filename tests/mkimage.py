@@ -0,0 +1,246 @@
+# ------------------------------------------------------------------------------------------------
+# Make small synthetic NTFS volume images and the listings NTFSfastFind should report for them.
+#
+# Project: NTFSfastFind
+# Author:  NTFSfastFind contributors   Oct-2026
+# https://landenlabs.com
+#
+# Each image holds a boot sector and an MFT of 64 records, the $MFT system records, a root
+# directory and a few directories and files, one deleted. Images differ in record size,
+# cluster size and how the MFT data runs are laid out, see sImages.
+#
+#   python mkimage.py [outDir]      default outDir is images next to this script
+#
+# Writes <name>.img and the expected output of each case in runtests.bat, <name>-<case>.out.
+# ------------------------------------------------------------------------------------------------
+
+import os
+import struct
+import sys
+
+sSectorSize = 512           # Update sequence stride, and boot sector bytes per sector.
+sRecordCnt = 64
+sRootIdx = 5
+sUsn = 7
+
+sDirFlag = 0x10000000       # $FILE_NAME flag of directory.
+sSystemAttr = 0x06          # Hidden + system.
+sArchiveAttr = 0x20
+
+# name, record size, cluster size, MFT runs (lcn, clusters), big.bin runs (lcn, clusters).
+sImages = [
+    # 1 KB records on 4 KB clusters, 3 runs, last one before the first.
+    ('rec1k', 1024, 4096, [(16, 3), (40, 5), (8, 8)], [(60, 3), (70, 2)]),
+    # 4 KB records on 4 KB clusters, one run, read in place.
+    ('rec4k', 4096, 4096, [(4, 64)], [(80, 3), (90, 2)]),
+    # 4 KB records on 1 KB clusters, runs of odd length so records span runs.
+    ('rec4k-split', 4096, 1024, [(16, 6), (300, 11), (30, 7), (100, 30), (400, 202)], [(620, 3), (640, 2)]),
+]
+
+sSystemNames = ['$MFT', '$MFTMirr', '$LogFile', '$Volume', '$AttrDef', '.', '$Bitmap',
+                '$Boot', '$BadClus', '$Secure', '$UpCase', '$Extend']
+
+
+# ------------------------------------------------------------------------------------------------
+class File:
+    def __init__(self, idx, name, parent, isDir=False, inUse=True, attr=sArchiveAttr, runs=None):
+        self.idx = idx
+        self.name = name
+        self.parent = parent
+        self.isDir = isDir
+        self.inUse = inUse
+        self.attr = attr | (sDirFlag if isDir else 0)
+        self.runs = runs
+
+
+# ------------------------------------------------------------------------------------------------
+# Records 0..11 system files, 12..15 reserved (free), user files from 16.
+def MakeFiles(mftRuns, bigRuns):
+    files = []
+    for idx, name in enumerate(sSystemNames):
+        isDir = idx in (sRootIdx, 11)
+        files.append(File(idx, name, sRootIdx, isDir, True, sSystemAttr, mftRuns if idx == 0 else None))
+
+    files.append(File(16, 'docs', sRootIdx, isDir=True))
+    files.append(File(17, 'readme.txt', sRootIdx))
+    files.append(File(18, 'a.log', 16))
+    files.append(File(19, 'old.tmp', sRootIdx, inUse=False))
+    files.append(File(20, 'sub', 16, isDir=True))
+    files.append(File(21, 'big.bin', 16, runs=bigRuns))
+    files.append(File(22, 'gone.txt', 16, inUse=False))
+    parents = [sRootIdx, 16, 20]
+    exts = ['.txt', '.log', '.dat']
+    for idx in range(23, sRecordCnt):
+        files.append(File(idx, 'file%02d%s' % (idx, exts[idx % 3]), parents[idx % 3]))
+    return files
+
+
+# ------------------------------------------------------------------------------------------------
+def Attribute(attrType, attrId, value):
+    # Resident attribute, value follows 24 byte header.
+    full = (24 + len(value) + 7) & ~7
+    hdr = struct.pack('<IHHBBHHHIHBB', attrType, full, 0, 0, 0, 0, 0, attrId, len(value), 24, 0, 0)
+    return (hdr + value).ljust(full, b'\0')
+
+
+# ------------------------------------------------------------------------------------------------
+def EncodeRuns(runs):
+    out = b''
+    prevLcn = 0
+    for lcn, clusters in runs:
+        lenBytes = clusters.to_bytes((clusters.bit_length() + 8) // 8, 'little')
+        delta = lcn - prevLcn
+        offSize = 1
+        while not (-(1 << (8 * offSize - 1)) <= delta < (1 << (8 * offSize - 1))):
+            offSize += 1
+        offBytes = delta.to_bytes(offSize, 'little', signed=True)
+        out += bytes([(len(offBytes) << 4) | len(lenBytes)]) + lenBytes + offBytes
+        prevLcn = lcn
+    return out + b'\0'
+
+
+# ------------------------------------------------------------------------------------------------
+def NonResident(attrType, attrId, runs, clusterSize, realSize):
+    clusters = sum(run[1] for run in runs)
+    runList = EncodeRuns(runs)
+    full = (64 + len(runList) + 7) & ~7
+    hdr = struct.pack('<IHHBBHHH', attrType, full, 0, 1, 0, 0, 0, attrId)
+    hdr += struct.pack('<qqHH4xqqq', 0, clusters - 1, 64, 0, clusters * clusterSize, realSize, realSize)
+    return (hdr + runList).ljust(full, b'\0')
+
+
+# ------------------------------------------------------------------------------------------------
+def FileName(parent, name, attr, size):
+    nameUtf16 = name.encode('utf-16-le')
+    nameType = 3 if name.startswith('$') or name == '.' else 1
+    time = 0x01d0000000000000
+    return struct.pack('<QqqqqqqIIBB', parent | (1 << 48), time, time, time, time, size, size,
+                       attr, 0, len(name), nameType) + nameUtf16
+
+
+# ------------------------------------------------------------------------------------------------
+def MakeRecord(idx, file, recSize, clusterSize, bitmap):
+    sectors = recSize // sSectorSize
+    usaOffset = 0x30
+    attrOffset = (usaOffset + 2 * (sectors + 1) + 7) & ~7
+    time = 0x01d0000000000000
+
+    attrs = b''
+    if file is not None:
+        stdInfo = struct.pack('<qqqqIIII', time, time, time, time, file.attr & 0xffff, 0, 0, 0)
+        attrs += Attribute(0x10, 0, stdInfo)
+        dataSize = 0
+        if file.runs is not None:
+            dataSize = sum(run[1] for run in file.runs) * clusterSize
+            if file.idx == 0:
+                dataSize = sRecordCnt * recSize
+        attrs += Attribute(0x30, 1, FileName(file.parent, file.name, file.attr, dataSize))
+        if file.runs is not None:
+            attrs += NonResident(0x80, 2, file.runs, clusterSize, dataSize)
+        if file.idx == 0:
+            attrs += Attribute(0xb0, 3, bitmap)
+    attrs += struct.pack('<II', 0xffffffff, 0)
+
+    flags = 0
+    if file is not None and file.inUse:
+        flags |= 0x01
+    if file is not None and file.isDir:
+        flags |= 0x02
+    hdr = struct.pack('<4sHHqHHHHIIqHHI', b'FILE', usaOffset, sectors + 1, 0, 1, 1, attrOffset, flags,
+                      attrOffset + len(attrs), recSize, 0, 4, 0, idx)
+    record = bytearray(hdr.ljust(attrOffset, b'\0') + attrs)
+    assert len(record) <= recSize - 2
+    record = record.ljust(recSize, b'\0')
+
+    # Update sequence, last WORD of each sector moves to the array and is replaced by the USN.
+    struct.pack_into('<H', record, usaOffset, sUsn)
+    for sector in range(sectors):
+        end = (sector + 1) * sSectorSize - 2
+        record[usaOffset + 2 + 2 * sector:usaOffset + 4 + 2 * sector] = record[end:end + 2]
+        struct.pack_into('<H', record, end, sUsn)
+    return bytes(record)
+
+
+# ------------------------------------------------------------------------------------------------
+def BootSector(recSize, clusterSize, mftLcn, totalSectors):
+    if recSize >= clusterSize:
+        clustersPerRecord = recSize // clusterSize
+    else:
+        clustersPerRecord = (-(recSize.bit_length() - 1)) & 0xff
+    bpb = struct.pack('<HBH3sHBHHHIIIqqqII', sSectorSize, clusterSize // sSectorSize, 0, b'\0\0\0', 0,
+                      0xf8, 0, 63, 255, 0, 0x800080, 0, totalSectors, mftLcn, 2, clustersPerRecord, 1)
+    bpb += struct.pack('<qI', 0x1234567890abcdef, 0)
+    boot = b'\xeb\x52\x90' + b'NTFS    ' + bpb
+    return boot.ljust(510, b'\0') + b'\x55\xaa'
+
+
+# ------------------------------------------------------------------------------------------------
+def Path(file, byIdx):
+    parts = [file.name]
+    parent = file.parent
+    while parent != sRootIdx:
+        parts.insert(0, byIdx[parent].name)
+        parent = byIdx[parent].parent
+    return '\\' + '\\'.join(parts)
+
+
+# ------------------------------------------------------------------------------------------------
+def Listing(files, byIdx, clusterSize, deleted=False, suffix=None, showVcn=False):
+    lines = ['Path']
+    for file in files:
+        if file.inUse == deleted or (suffix is not None and not file.name.endswith(suffix)):
+            continue
+        line = ''
+        if showVcn and file.runs is not None:
+            line += ' VCN(%d) ' % len(file.runs)
+            for lcn, clusters in file.runs:
+                line += '%d#%d ' % (lcn, clusters)
+        lines.append(line + Path(file, byIdx))
+    return ''.join(line + '\r\n' for line in lines).encode('ascii')
+
+
+# ------------------------------------------------------------------------------------------------
+def MakeImage(outDir, name, recSize, clusterSize, mftRuns, bigRuns):
+    files = MakeFiles(mftRuns, bigRuns)
+    byIdx = dict((file.idx, file) for file in files)
+    assert sum(run[1] for run in mftRuns) * clusterSize == sRecordCnt * recSize
+
+    bitmap = bytearray(sRecordCnt // 8)
+    for file in files:
+        if file.inUse:
+            bitmap[file.idx // 8] |= 1 << (file.idx % 8)
+
+    mft = b''
+    for idx in range(sRecordCnt):
+        mft += MakeRecord(idx, byIdx.get(idx), recSize, clusterSize, bytes(bitmap))
+
+    lastCluster = max(lcn + clusters for lcn, clusters in mftRuns + bigRuns)
+    image = bytearray(lastCluster * clusterSize)
+    image[0:512] = BootSector(recSize, clusterSize, mftRuns[0][0], len(image) // sSectorSize - 1)
+    mftOff = 0
+    for lcn, clusters in mftRuns:
+        runLen = clusters * clusterSize
+        image[lcn * clusterSize:lcn * clusterSize + runLen] = mft[mftOff:mftOff + runLen]
+        mftOff += runLen
+
+    with open(os.path.join(outDir, name + '.img'), 'wb') as out:
+        out.write(image)
+
+    cases = {
+        'all': Listing(files, byIdx, clusterSize),
+        'deleted': Listing(files, byIdx, clusterSize, deleted=True),
+        'txt': Listing(files, byIdx, clusterSize, suffix='.txt'),
+        'vcn': Listing(files, byIdx, clusterSize, showVcn=True),
+    }
+    for case, listing in cases.items():
+        with open(os.path.join(outDir, '%s-%s.out' % (name, case)), 'wb') as out:
+            out.write(listing)
+
+
+# ------------------------------------------------------------------------------------------------
+if __name__ == '__main__':
+    outDir = sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(os.path.abspath(__file__)), 'images')
+    if not os.path.isdir(outDir):
+        os.makedirs(outDir)
+    for image in sImages:
+        MakeImage(outDir, *image)
@@ -0,0 +1,52 @@
+@echo off
+
+@rem
+@rem  Scan the synthetic NTFS images in tests\images and compare each listing with the
+@rem  expected one. Images and listings are made by mkimage.py.
+@rem
+@rem    tests\runtests.bat [path\NTFSfastFind.exe]     default x64\Release\NTFSfastFind.exe
+@rem
+
+setlocal
+set prog=%~1
+if "%prog%"=="" set prog=%~dp0..\x64\Release\NTFSfastFind.exe
+set images=%~dp0images
+set outdir=%TEMP%\ntfsfastfind-tests
+set fails=0
+set runs=0
+
+if not exist "%prog%" (
+   echo Missing %prog%, build it first or pass its path
+   exit /b 1
+)
+if not exist "%outdir%" mkdir "%outdir%"
+
+for %%i in (rec1k rec4k rec4k-split) do (
+   call :check %%i all     all
+   call :check %%i all     serial    -j 0
+   call :check %%i all     stream    -M 1
+   call :check %%i all     sequence  -q
+   call :check %%i all     filter    -f *
+   call :check %%i txt     txt       -f *.txt
+   call :check %%i deleted deleted   -X
+   call :check %%i vcn     vcn       -V
+)
+
+@echo.
+@echo ---- %fails% of %runs% failed
+if not "%fails%"=="0" exit /b 1
+exit /b 0
+
+@rem  check image expected label [options]
+:check
+set /a runs+=1
+set actual=%outdir%\%1-%3.txt
+"%prog%" %4 %5 %6 %7 -i "%images%\%1.img" > "%actual%" 2>&1
+fc "%images%\%1-%2.out" "%actual%" > nul
+if errorlevel 1 (
+   echo FAIL %1 %3: %4 %5 %6 %7, see %actual%
+   set /a fails+=1
+) else (
+   echo ok   %1 %3
+)
+goto :eof